@@ -0,0 +1,748 @@
+// Benchmarks for the vvh helper layer. Runs headless (no window, no surface), e.g. on lavapipe, and writes JSON.
+//
+//   bench_helpers [--shader shaders/shader.spv] [--out bench_helpers.json] [--quick]
+//
+// Pipeline creation and draw recording need the compiled shader, they are reported as skipped without it.
+// Recorded draws are never submitted, only the CPU cost of recording is measured.
+// The push descriptor and descriptor buffer benchmarks need VK_KHR_push_descriptor, and Vulkan 1.3 with
+// VK_EXT_descriptor_buffer (lavapipe has all of them), else they are skipped.
+
+#define VIENNA_VULKAN_HELPER_IMPL
+#include "VHInclude2.h"
+
+#include <filesystem>
+#include <fstream>
+
+
+namespace bench {
+
+	struct Result {
+		std::string m_name;
+		uint64_t 	m_param{0};		//problem size, e.g. number of objects
+		uint32_t 	m_iterations{0};
+		double 		m_medianMs{0};
+		double 		m_minMs{0};
+		double 		m_rate{0};		//throughput computed from the median
+		std::string m_unit;
+		std::string m_skipped;		//reason if the benchmark did not run
+	};
+
+	/// Mirrors the members of the engine's VulkanState that the helpers read, so it can be passed to them directly.
+	struct Vulkan {
+		std::vector<std::string> m_instanceExtensions;
+		std::vector<std::string> m_deviceExtensions;
+		std::vector<std::string> m_validationLayers;
+		std::string 		m_name{"bench_helpers"};
+		bool 				m_debug{false};
+		uint32_t 			m_apiVersion{VK_API_VERSION_1_3};	//asked of the instance, then what the device offers up to 1.3
+		uint32_t 			m_vmaApiVersion{VK_API_VERSION_1_1};
+		VkInstance 			m_instance{VK_NULL_HANDLE};
+		VkSurfaceKHR 		m_surface{VK_NULL_HANDLE};	//headless
+		VkPhysicalDevice 	m_physicalDevice{VK_NULL_HANDLE};
+		VkPhysicalDeviceProperties m_properties{};
+		vvh::QueueFamilyIndices m_queueFamilies;
+		VkDevice 			m_device{VK_NULL_HANDLE};
+		VkQueue 			m_graphicsQueue{VK_NULL_HANDLE};
+		VkQueue 			m_presentQueue{VK_NULL_HANDLE};
+		VmaAllocator 		m_vmaAllocator{nullptr};
+		VkCommandPool 		m_commandPool{VK_NULL_HANDLE};
+		vvh::SwapChain 		m_swapChain;
+		vvh::DepthImage 	m_depthImage;
+		VkFormat 			m_depthFormat{VK_FORMAT_UNDEFINED};
+		VkRenderPass 		m_renderPass{VK_NULL_HANDLE};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		bool 				m_pushDescriptors{false};	//VK_KHR_push_descriptor is enabled
+		bool 				m_descriptorBuffer{false};	//VK_EXT_descriptor_buffer and bufferDeviceAddress are enabled
+	};
+
+	/// @brief Run func iterations times and return the median and the fastest run in milliseconds.
+	template<typename F>
+	auto Measure(uint32_t iterations, F&& func) -> std::pair<double, double> {
+		std::vector<double> times;
+		for( uint32_t i = 0; i < iterations; ++i ) {
+			auto start = std::chrono::high_resolution_clock::now();
+			func(i);
+			auto end = std::chrono::high_resolution_clock::now();
+			times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		std::sort(times.begin(), times.end());
+		return { times[times.size() / 2], times[0] };
+	}
+
+	auto MakeResult(std::string name, uint64_t param, uint32_t iterations, std::pair<double, double> ms, double amount, std::string unit) -> Result {
+		return { name, param, iterations, ms.first, ms.second, ms.first > 0 ? amount / (ms.first / 1000.0) : 0.0, unit, "" };
+	}
+
+	/// @brief A mesh with positions, normals, uvs and tangents (PNUT) and one triangle per three vertices.
+	auto MakeMesh(uint32_t vertices) -> vvh::Mesh {
+		vvh::Mesh mesh{};
+		mesh.m_verticesData.m_positions.resize(vertices, glm::vec3{0.0f});
+		mesh.m_verticesData.m_normals.resize(vertices, glm::vec3{0.0f, 0.0f, 1.0f});
+		mesh.m_verticesData.m_texCoords.resize(vertices, glm::vec2{0.0f});
+		mesh.m_verticesData.m_tangents.resize(vertices, glm::vec3{1.0f, 0.0f, 0.0f});
+		for( uint32_t i = 0; i < vertices; ++i ) {
+			mesh.m_verticesData.m_positions[i] = glm::vec3{ (float)(i % 3 == 1), (float)(i % 3 == 2), 0.0f };
+			mesh.m_indices.push_back(i);
+		}
+		return mesh;
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	void Init(Vulkan& vk) {
+		vvh::DevCreateInstance( {
+			.m_validationLayers 	= vk.m_validationLayers,
+			.m_instanceExtensions 	= vk.m_instanceExtensions,
+			.m_name 				= vk.m_name,
+			.m_apiVersion 			= vk.m_apiVersion,
+			.m_debug 				= vk.m_debug,
+			.m_instance 			= vk.m_instance
+		});
+
+		vk.m_apiVersion = VK_API_VERSION_1_1;
+		vvh::DevPickPhysicalDevice(vk);
+		vk.m_apiVersion = std::min(vk.m_apiVersion, VK_API_VERSION_1_3);
+		vkGetPhysicalDeviceProperties(vk.m_physicalDevice, &vk.m_properties);
+		vk.m_depthFormat = vvh::RenFindDepthFormat(vk.m_physicalDevice);
+
+		//optional descriptor paths, their benchmarks are skipped if the device does not have them
+		std::vector<std::string> pushDescriptor{ VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME };
+		vk.m_pushDescriptors = vvh::DevCheckDeviceExtensionSupport({ vk.m_physicalDevice, pushDescriptor });
+		if( vk.m_pushDescriptors ) vk.m_deviceExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
+		VkPhysicalDeviceBufferDeviceAddressFeatures addressFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES };
+		addressFeatures.bufferDeviceAddress = VK_TRUE;
+		VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT, &addressFeatures };
+		descriptorBufferFeatures.descriptorBuffer = VK_TRUE;
+		vk.m_descriptorBuffer = vvh::DescriptorBuffer::Supported(vk.m_physicalDevice, vk.m_apiVersion);
+		if( vk.m_descriptorBuffer ) {
+			vk.m_deviceExtensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+			vk.m_vmaApiVersion = VK_API_VERSION_1_3;	//buffer device addresses are core
+		}
+
+		vvh::DevCreateLogicalDevice( {
+			.m_surface 			= vk.m_surface,
+			.m_physicalDevice 	= vk.m_physicalDevice,
+			.m_validationLayers = vk.m_validationLayers,
+			.m_deviceExtensions = vk.m_deviceExtensions,
+			.m_debug 			= vk.m_debug,
+			.m_queueFamilies 	= vk.m_queueFamilies,
+			.m_device 			= vk.m_device,
+			.m_graphicsQueue 	= vk.m_graphicsQueue,
+			.m_presentQueue 	= vk.m_presentQueue,
+			.m_pNext 			= vk.m_descriptorBuffer ? &descriptorBufferFeatures : nullptr
+		});
+
+		vvh::DevInitVMA( {
+			.m_instance 		= vk.m_instance,
+			.m_physicalDevice 	= vk.m_physicalDevice,
+			.m_device 			= vk.m_device,
+			.m_apiVersion 		= vk.m_vmaApiVersion,
+			.m_vmaAllocator 	= vk.m_vmaAllocator,
+			.m_bufferDeviceAddress = vk.m_descriptorBuffer
+		});
+
+		vvh::ComCreateCommandPool( {
+			.m_surface 			= vk.m_surface,
+			.m_physicalDevice 	= vk.m_physicalDevice,
+			.m_device 			= vk.m_device,
+			.m_commandPool 		= vk.m_commandPool
+		});
+
+		VkExtent2D extent{ 1280, 720 };
+		vvh::DevCreateOffscreenSwapChain( {
+			.m_physicalDevice 	= vk.m_physicalDevice,
+			.m_device 			= vk.m_device,
+			.m_vmaAllocator 	= vk.m_vmaAllocator,
+			.m_extent 			= extent,
+			.m_swapChain 		= vk.m_swapChain
+		});
+		vvh::DevCreateImageViews(vk);
+
+		vvh::RenCreateRenderPass( {
+			.m_depthFormat 	= vk.m_depthFormat,
+			.m_device 		= vk.m_device,
+			.m_swapChain 	= vk.m_swapChain,
+			.m_clear 		= true,
+			.m_renderPass 	= vk.m_renderPass
+		});
+		vvh::RenCreateDepthResources(vk);
+		vvh::RenCreateFramebuffers(vk);
+	}
+
+	void Quit(Vulkan& vk) {
+		vkDeviceWaitIdle(vk.m_device);
+		vvh::DevCleanupSwapChain(vk);
+		vkDestroyRenderPass(vk.m_device, vk.m_renderPass, nullptr);
+		vkDestroyCommandPool(vk.m_device, vk.m_commandPool, nullptr);
+		vmaDestroyAllocator(vk.m_vmaAllocator);
+		vkDestroyDevice(vk.m_device, nullptr);
+		vkDestroyInstance(vk.m_instance, nullptr);
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	void BenchVertexUpload(Vulkan& vk, uint32_t iterations, std::vector<Result>& results) {
+		for( uint32_t vertices : { 1'000u, 100'000u, 1'000'000u } ) {
+			vvh::Mesh mesh = MakeMesh(vertices);
+			double megabytes = mesh.m_verticesData.getSize() / 1e6;
+			auto ms = Measure(iterations, [&](uint32_t) {
+				vvh::BufCreateVertexBuffer( {
+					.m_physicalDevice 	= vk.m_physicalDevice,
+					.m_device 			= vk.m_device,
+					.m_vmaAllocator 	= vk.m_vmaAllocator,
+					.m_graphicsQueue 	= vk.m_graphicsQueue,
+					.m_commandPool 		= vk.m_commandPool,
+					.m_mesh 			= mesh
+				});
+				vvh::BufDestroyBuffer({vk.m_device, vk.m_vmaAllocator, mesh.m_vertexBuffer, mesh.m_vertexBufferAllocation});
+			});
+			results.push_back(MakeResult("BufCreateVertexBuffer", vertices, iterations, ms, megabytes, "MB/s"));
+		}
+	}
+
+	void BenchTextureUpload(Vulkan& vk, uint32_t iterations, std::vector<Result>& results) {
+		for( int size : { 256, 1024, 2048 } ) {
+			size_t bytes = (size_t)size * size * 4;
+			std::vector<uint8_t> pixels(bytes);
+			for( size_t i = 0; i < bytes; ++i ) pixels[i] = (uint8_t)(i * 31);
+			auto ms = Measure(iterations, [&](uint32_t) {
+				vvh::Image texture{};
+				vvh::ImgCreateTextureImage( {
+					.m_physicalDevice 	= vk.m_physicalDevice,
+					.m_device 			= vk.m_device,
+					.m_vmaAllocator 	= vk.m_vmaAllocator,
+					.m_graphicsQueue 	= vk.m_graphicsQueue,
+					.m_commandPool 		= vk.m_commandPool,
+					.m_pixels 			= pixels.data(),
+					.m_width 			= size,
+					.m_height 			= size,
+					.m_size 			= bytes,
+					.m_texture 			= texture
+				});
+				vvh::ImgDestroyImage({vk.m_device, vk.m_vmaAllocator, texture.m_mapImage, texture.m_mapImageAllocation});
+			});
+			results.push_back(MakeResult("ImgCreateTextureImage", (uint64_t)size, iterations, ms, bytes / 1e6, "MB/s"));
+		}
+	}
+
+	/// @brief Write an uncompressed, single level RGBA8 KTX2 file.
+	void WriteKTX2(const std::string& filename, uint32_t size, uint8_t seed) {
+		static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+		uint32_t header[13] = { VK_FORMAT_R8G8B8A8_UNORM, 1, size, size, 0, 0, 1, 1, 0, 0, 0, 0, 0 };
+		uint64_t sgd[2] = { 0, 0 };
+		uint64_t bytes = (uint64_t)size * size * 4;
+		uint64_t level[3] = { sizeof(identifier) + sizeof(header) + sizeof(sgd) + sizeof(level), bytes, bytes };
+		std::vector<uint8_t> pixels(bytes);
+		for( size_t i = 0; i < pixels.size(); ++i ) pixels[i] = (uint8_t)(i * 31 + seed);
+		std::ofstream file(filename, std::ios::binary);
+		file.write((const char*)identifier, sizeof(identifier));
+		file.write((const char*)header, sizeof(header));
+		file.write((const char*)sgd, sizeof(sgd));
+		file.write((const char*)level, sizeof(level));
+		file.write((const char*)pixels.data(), pixels.size());
+	}
+
+	/// @brief Load many textures through the TextureLoader until all are ready, including Init() and Destroy().
+	/// With the small ring most textures do not fit while the workers decode, so they are staged by Update().
+	void BenchTextureLoader(Vulkan& vk, uint32_t iterations, std::vector<Result>& results) {
+		const uint32_t size = 256, files = 16;
+		auto dir = std::filesystem::temp_directory_path() / "bench_helpers_textures";
+		std::filesystem::create_directories(dir);
+		std::vector<std::string> names;
+		for( uint32_t i = 0; i < files; ++i ) {
+			names.push_back((dir / ("texture" + std::to_string(i) + ".ktx2")).string());
+			WriteKTX2(names.back(), size, (uint8_t)i);
+		}
+
+		vvh::ThreadPool pool;
+		vvh::SamplerCache samplers;
+		samplers.Init(vk.m_physicalDevice, vk.m_device);
+		for( VkDeviceSize ring : { (VkDeviceSize)64 << 20, (VkDeviceSize)1 << 20 } ) {
+			for( uint32_t count : { 64u, 256u } ) {
+				auto ms = Measure(iterations, [&](uint32_t) {
+					vvh::TextureLoader loader(pool);
+					loader.Init(vk.m_physicalDevice, vk.m_device, vk.m_vmaAllocator, vk.m_graphicsQueue,
+						vk.m_queueFamilies.graphicsFamily.value(), samplers, ring);
+					for( uint32_t i = 0; i < count; ++i ) loader.Load(names[i % files], false);
+					loader.WaitIdle();
+					loader.Destroy();
+				});
+				double megabytes = count * (double)size * size * 4 / 1e6;
+				results.push_back(MakeResult(ring < (64 << 20) ? "TextureLoaderSmallRing" : "TextureLoader", count, iterations, ms, megabytes, "MB/s"));
+			}
+		}
+		samplers.Destroy();
+		std::filesystem::remove_all(dir);
+	}
+
+	//---------------------------------------------------------------------------------------------
+	// Layouts matching shader.slang: set 0 per frame, set 1 per object, vertex attributes PNUT.
+
+	struct Layouts {
+		VkDescriptorSetLayout m_frame{VK_NULL_HANDLE};
+		VkDescriptorSetLayout m_object{VK_NULL_HANDLE};
+	};
+
+	auto CreateLayouts(Vulkan& vk) -> Layouts {
+		Layouts layouts;
+		const VkShaderStageFlags stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		vvh::RenCreateDescriptorSetLayout( {
+			.m_device = vk.m_device,
+			.m_bindings = {
+				{ .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .stageFlags = stages },
+				{ .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .stageFlags = stages },
+				{ .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .stageFlags = stages }
+			},
+			.m_descriptorSetLayout = layouts.m_frame
+		});
+		vvh::RenCreateDescriptorSetLayout( {
+			.m_device = vk.m_device,
+			.m_bindings = {
+				{ .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .stageFlags = stages },
+				{ .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .stageFlags = stages }
+			},
+			.m_descriptorSetLayout = layouts.m_object
+		});
+		return layouts;
+	}
+
+	void BenchPipeline(Vulkan& vk, const std::string& shader, const Layouts& layouts, uint32_t iterations,
+						std::vector<Result>& results, vvh::Pipeline& pipeline) {
+
+		std::vector<VkVertexInputBindingDescription> bindings = {
+			{ 0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX }, { 1, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX },
+			{ 2, sizeof(glm::vec2), VK_VERTEX_INPUT_RATE_VERTEX }, { 3, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX } };
+		std::vector<VkVertexInputAttributeDescription> attributes = {
+			{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 }, { 1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0 },
+			{ 2, 2, VK_FORMAT_R32G32_SFLOAT, 0 }, { 3, 3, VK_FORMAT_R32G32B32_SFLOAT, 0 } };
+		std::vector<VkPushConstantRange> pushConstants = { { VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(vvh::LightOffset) } };
+
+		bool created = false;
+		auto create = [&](VkPipelineCache cache) {
+			if( created ) {
+				vkDestroyPipeline(vk.m_device, pipeline.m_pipeline, nullptr);
+				vkDestroyPipelineLayout(vk.m_device, pipeline.m_pipelineLayout, nullptr);
+			}
+			created = true;
+			vvh::RenCreateGraphicsPipeline( {
+				.m_device 					= vk.m_device,
+				.m_renderPass 				= vk.m_renderPass,
+				.m_vertShaderPath 			= shader,
+				.m_fragShaderPath 			= shader,
+				.m_bindingDescription 		= bindings,
+				.m_attributeDescriptions 	= attributes,
+				.m_descriptorSetLayouts 	= { layouts.m_frame, layouts.m_object },
+				.m_specializationConstants 	= {},
+				.m_pushConstantRanges 		= pushConstants,
+				.m_blendAttachments 		= {},
+				.m_graphicsPipeline 		= pipeline,
+				.m_pAllocator 				= nullptr,
+				.m_pipelineCache 			= cache
+			});
+		};
+
+		auto ms = Measure(iterations, [&](uint32_t) { create(VK_NULL_HANDLE); });
+		results.push_back(MakeResult("RenCreateGraphicsPipeline", 1, iterations, ms, 1.0, "pipelines/s"));
+
+		//a warm cache, as a later launch with a persistent PipelineCache would see it
+		VkPipelineCacheCreateInfo cacheInfo{ .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+		VkPipelineCache cache{VK_NULL_HANDLE};
+		vkCreatePipelineCache(vk.m_device, &cacheInfo, nullptr, &cache);
+		create(cache);
+		ms = Measure(iterations, [&](uint32_t) { create(cache); });
+		results.push_back(MakeResult("RenCreateGraphicsPipelineCached", 1, iterations, ms, 1.0, "pipelines/s"));
+		vkDestroyPipelineCache(vk.m_device, cache, nullptr);
+	}
+
+	/// @brief Warm many permutations at once, they only differ in a specialization constant so none is a cache hit.
+	void BenchPipelineBuilder(Vulkan& vk, const std::string& shader, const Layouts& layouts, uint32_t iterations,
+						std::vector<Result>& results) {
+
+		vvh::ThreadPool pool;
+		vvh::ShaderLibrary library;
+		library.Init(vk.m_device);
+		vvh::PipelineBuilder builder;
+		builder.Init(pool, library, vk.m_device);
+		vvh::PipelineDesc desc{
+			.m_renderPass 				= vk.m_renderPass,
+			.m_vertShaderPath 			= shader,
+			.m_fragShaderPath 			= shader,
+			.m_bindingDescription 		= {
+				{ 0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX }, { 1, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX },
+				{ 2, sizeof(glm::vec2), VK_VERTEX_INPUT_RATE_VERTEX }, { 3, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX } },
+			.m_attributeDescriptions 	= {
+				{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 }, { 1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0 },
+				{ 2, 2, VK_FORMAT_R32G32_SFLOAT, 0 }, { 3, 3, VK_FORMAT_R32G32B32_SFLOAT, 0 } },
+			.m_descriptorSetLayouts 	= { layouts.m_frame, layouts.m_object },
+			.m_pushConstantRanges 		= { { VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(vvh::LightOffset) } }
+		};
+
+		int32_t permutation = 0;
+		for( uint32_t count : { 64u, 256u } ) {
+			std::vector<vvh::PipelineBuilder::Future> built;
+			auto destroy = [&]() {
+				for( auto& future : built ) {
+					vkDestroyPipeline(vk.m_device, future.get().m_pipeline, nullptr);
+					vkDestroyPipelineLayout(vk.m_device, future.get().m_pipelineLayout, nullptr);
+				}
+				built.clear();
+			};
+			auto ms = Measure(iterations, [&](uint32_t) {
+				destroy();
+				for( uint32_t i = 0; i < count; ++i ) {
+					desc.m_specializationConstants = { permutation++ };
+					built.push_back(builder.Submit(desc));
+				}
+				builder.Wait();
+			});
+			destroy();
+			results.push_back(MakeResult("PipelineBuilder", count, iterations, ms, count, "pipelines/s"));
+		}
+		builder.Destroy();
+		library.Destroy();
+	}
+
+	/// @brief Per draw lookup cost once all permutations exist, plus how long creating them lazily took.
+	void BenchPipelineRegistry(Vulkan& vk, const std::string& shader, const Layouts& layouts, uint32_t iterations,
+						std::vector<Result>& results) {
+
+		vvh::ShaderLibrary library;
+		library.Init(vk.m_device);
+		vvh::PipelineRegistry registry;
+		registry.Init(vk.m_device, library);
+		uint32_t program = registry.AddProgram({
+			.m_vertShaderPath 		= shader,
+			.m_fragShaderPath 		= shader,
+			.m_descriptorSetLayouts = { layouts.m_frame, layouts.m_object },
+			.m_pushConstantRanges 	= { { VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(vvh::LightOffset) } }
+		});
+
+		const uint32_t permutations = 64, lookups = 1'000'000;
+		vvh::PipelineKey key{ .m_program = program, .m_vertexFormat = vvh::VERTEX_POSITION | vvh::VERTEX_NORMAL | vvh::VERTEX_TEXCOORD | vvh::VERTEX_TANGENT,
+			.m_renderPass = vk.m_renderPass, .m_specializationCount = 1 };
+		auto start = std::chrono::high_resolution_clock::now();
+		for( uint32_t i = 0; i < permutations; ++i ) {
+			key.m_specialization[0] = (int32_t)i;
+			registry.Get(key);
+		}
+		double createMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		results.push_back(MakeResult("PipelineRegistryCreate", permutations, 1, { createMs, createMs }, permutations, "pipelines/s"));
+
+		uint64_t sum = 0;
+		auto ms = Measure(iterations, [&](uint32_t) {
+			for( uint32_t i = 0; i < lookups; ++i ) {
+				key.m_specialization[0] = (int32_t)(i % permutations);
+				sum += (uint64_t)registry.Get(key).m_pipeline;
+			}
+		});
+		results.push_back(MakeResult("PipelineRegistryGet", lookups, iterations, ms, lookups, "lookups/s"));
+		volatile uint64_t sink = sum;		//keep the lookups from being optimized away
+		(void)sink;
+		registry.Destroy();
+		library.Destroy();
+	}
+
+	void BenchDescriptors(Vulkan& vk, const Layouts& layouts, const vvh::Image& texture, const vvh::Buffer& ubo,
+						uint32_t iterations, std::vector<Result>& results) {
+
+		for( uint32_t objects : { 1'000u, 10'000u, 100'000u } ) {
+			VkDescriptorPool pool;
+			vvh::RenCreateDescriptorPool({ .m_device = vk.m_device, .m_sizes = objects * MAX_FRAMES_IN_FLIGHT, .m_descriptorPool = pool });
+			std::vector<vvh::DescriptorSet> sets(objects, vvh::DescriptorSet{1});
+			for( auto& set : sets ) vvh::RenCreateDescriptorSet({vk.m_device, layouts.m_object, pool, set});
+
+			//one buffer and one texture write per object and frame in flight
+			auto ms = Measure(iterations, [&](uint32_t) {
+				for( auto& set : sets ) {
+					vvh::RenUpdateDescriptorSet( {
+						.m_device 			= vk.m_device,
+						.m_uniformBuffers 	= ubo,
+						.m_binding 			= 0,
+						.m_type 			= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+						.m_size 			= sizeof(vvh::BufferPerObjectTexture),
+						.m_descriptorSet 	= set
+					});
+					vvh::RenUpdateDescriptorSetTexture({vk.m_device, texture, 1, set});
+				}
+			});
+			vkDestroyDescriptorPool(vk.m_device, pool, nullptr);
+			results.push_back(MakeResult("RenUpdateDescriptorSet", objects, iterations, ms, 2.0 * objects * MAX_FRAMES_IN_FLIGHT, "writes/s"));
+		}
+	}
+
+	/// Records one push of an object's uniform buffer and texture per object, as a per-draw path would.
+	void BenchPushDescriptors(Vulkan& vk, const vvh::Image& texture, const vvh::Buffer& ubo, uint32_t iterations, std::vector<Result>& results) {
+		const std::vector<uint32_t> counts{ 1'000u, 10'000u, 100'000u };
+		if( !vk.m_pushDescriptors ) {
+			for( uint64_t objects : counts ) {
+				results.push_back({ .m_name = "ComPushDescriptors", .m_param = objects, .m_skipped = "VK_KHR_push_descriptor not supported" });
+			}
+			return;
+		}
+
+		VkShaderStageFlags stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		VkDescriptorSetLayout layout;
+		vvh::RenCreateDescriptorSetLayout( {
+			.m_device = vk.m_device,
+			.m_bindings = {
+				{ .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .stageFlags = stages },
+				{ .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .stageFlags = stages }
+			},
+			.m_descriptorSetLayout = layout,
+			.m_pushDescriptor = true
+		});
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &layout;
+		VkPipelineLayout pipelineLayout;
+		if( vkCreatePipelineLayout(vk.m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS ) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+		vvh::DescriptorSetKey key;
+		key.Buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, ubo.m_uniformBuffers[0], 0, sizeof(vvh::BufferPerObjectTexture)).Texture(1, texture);
+
+		std::vector<VkCommandBuffer> commandBuffers(1);
+		vvh::ComCreateCommandBuffers({vk.m_device, vk.m_commandPool, commandBuffers});
+		const VkCommandBuffer commandBuffer = commandBuffers[0];
+
+		for( uint32_t objects : counts ) {
+			auto ms = Measure(iterations, [&](uint32_t) {
+				vkResetCommandBuffer(commandBuffer, 0);
+				vvh::ComBeginCommandBuffer({commandBuffer});
+				for( uint32_t i = 0; i < objects; ++i ) vvh::ComPushDescriptors({commandBuffer, pipelineLayout, 0, key});
+				vvh::ComEndCommandBuffer({commandBuffer});
+			});
+			results.push_back(MakeResult("ComPushDescriptors", objects, iterations, ms, objects, "pushes/s"));
+		}
+
+		vkResetCommandBuffer(commandBuffer, 0);
+		vkFreeCommandBuffers(vk.m_device, vk.m_commandPool, 1, &commandBuffer);
+		vkDestroyPipelineLayout(vk.m_device, pipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(vk.m_device, layout, nullptr);
+	}
+
+	/// Writes one set per object into the frame part of a DescriptorBuffer, then records one Bind per object.
+	void BenchDescriptorBuffer(Vulkan& vk, const vvh::Image& texture, uint32_t iterations, std::vector<Result>& results) {
+		const std::vector<uint32_t> counts{ 1'000u, 10'000u, 100'000u };
+		if( !vk.m_descriptorBuffer ) {
+			for( uint64_t objects : counts ) {
+				results.push_back({ .m_name = "DescriptorBufferWrite", .m_param = objects, .m_skipped = "VK_EXT_descriptor_buffer not supported" });
+				results.push_back({ .m_name = "DescriptorBufferBind", .m_param = objects, .m_skipped = "VK_EXT_descriptor_buffer not supported" });
+			}
+			return;
+		}
+
+		//buffers referenced from a descriptor buffer need device addresses
+		vvh::Buffer ubo;
+		vvh::BufCreateBuffers({vk.m_device, vk.m_vmaAllocator, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			sizeof(vvh::BufferPerObjectTexture), ubo});
+		VkShaderStageFlags stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		VkDescriptorSetLayout layout;
+		vvh::RenCreateDescriptorSetLayout( {
+			.m_device = vk.m_device,
+			.m_bindings = {
+				{ .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .stageFlags = stages },
+				{ .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .stageFlags = stages }
+			},
+			.m_descriptorSetLayout = layout,
+			.m_descriptorBuffer = true
+		});
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &layout;
+		VkPipelineLayout pipelineLayout;
+		if( vkCreatePipelineLayout(vk.m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS ) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+		vvh::DescriptorSetKey key;
+		key.Buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, ubo.m_uniformBuffers[0], 0, sizeof(vvh::BufferPerObjectTexture)).Texture(1, texture);
+
+		std::vector<VkCommandBuffer> commandBuffers(1);
+		vvh::ComCreateCommandBuffers({vk.m_device, vk.m_commandPool, commandBuffers});
+		const VkCommandBuffer commandBuffer = commandBuffers[0];
+
+		for( uint32_t objects : counts ) {
+			vvh::DescriptorBuffer buffer;
+			try {
+				buffer.Init(vk.m_physicalDevice, vk.m_device, vk.m_vmaAllocator, 1 << 16, (VkDeviceSize)objects * 256, 1);
+				std::vector<std::vector<VkDeviceSize>> offsets(objects, std::vector<VkDeviceSize>(1));
+				auto writeMs = Measure(iterations, [&](uint32_t) {
+					buffer.BeginFrame(0);
+					for( auto& offset : offsets ) {
+						offset[0] = buffer.AllocateFrame(layout);
+						buffer.Write(offset[0], layout, key);
+					}
+				});
+				auto bindMs = Measure(iterations, [&](uint32_t) {
+					vkResetCommandBuffer(commandBuffer, 0);
+					vvh::ComBeginCommandBuffer({commandBuffer});
+					for( auto& offset : offsets ) buffer.Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, offset);
+					vvh::ComEndCommandBuffer({commandBuffer});
+				});
+				results.push_back(MakeResult("DescriptorBufferWrite", objects, iterations, writeMs, 2.0 * objects, "writes/s"));
+				results.push_back(MakeResult("DescriptorBufferBind", objects, iterations, bindMs, objects, "binds/s"));
+			} catch( const std::runtime_error& e ) {	//e.g. the device's descriptor buffer range is too small for this count
+				results.push_back({ .m_name = "DescriptorBufferWrite", .m_param = objects, .m_skipped = e.what() });
+				results.push_back({ .m_name = "DescriptorBufferBind", .m_param = objects, .m_skipped = e.what() });
+			}
+			vkResetCommandBuffer(commandBuffer, 0);
+			buffer.Destroy();
+		}
+
+		vkFreeCommandBuffers(vk.m_device, vk.m_commandPool, 1, &commandBuffer);
+		vkDestroyPipelineLayout(vk.m_device, pipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(vk.m_device, layout, nullptr);
+		vvh::BufDestroyBuffer2({vk.m_device, vk.m_vmaAllocator, ubo});
+	}
+
+	void BenchRecording(Vulkan& vk, const Layouts& layouts, const vvh::Pipeline& pipeline, uint32_t iterations, std::vector<Result>& results) {
+		vvh::Mesh mesh = MakeMesh(3);
+		vvh::BufCreateVertexBuffer({vk.m_physicalDevice, vk.m_device, vk.m_vmaAllocator, vk.m_graphicsQueue, vk.m_commandPool, mesh});
+		vvh::BufCreateIndexBuffer({vk.m_physicalDevice, vk.m_device, vk.m_vmaAllocator, vk.m_graphicsQueue, vk.m_commandPool, mesh});
+		const std::string type = mesh.m_verticesData.getType();
+
+		std::vector<VkCommandBuffer> commandBuffers(1);
+		vvh::ComCreateCommandBuffers({vk.m_device, vk.m_commandPool, commandBuffers});
+		const VkCommandBuffer commandBuffer = commandBuffers[0];
+		const uint32_t imageIndex = 0, currentFrame = 0;
+		const glm::vec4 clearColor{0.0f};
+		const std::array<float, 4> blendConstants{0.0f};
+
+		for( uint32_t objects : { 1'000u, 10'000u, 100'000u } ) {
+			VkDescriptorPool pool;
+			vvh::RenCreateDescriptorPool({ .m_device = vk.m_device, .m_sizes = (objects + 1) * MAX_FRAMES_IN_FLIGHT, .m_descriptorPool = pool });
+			vvh::DescriptorSet frameSet{0};
+			vvh::RenCreateDescriptorSet({vk.m_device, layouts.m_frame, pool, frameSet});
+			std::vector<vvh::DescriptorSet> objectSets(objects, vvh::DescriptorSet{1});
+			for( auto& set : objectSets ) vvh::RenCreateDescriptorSet({vk.m_device, layouts.m_object, pool, set});
+
+			auto ms = Measure(iterations, [&](uint32_t) {
+				vkResetCommandBuffer(commandBuffer, 0);
+				vvh::ComBeginCommandBuffer({commandBuffer});
+				vvh::ComBeginRenderPass({commandBuffer, imageIndex, vk.m_swapChain, vk.m_renderPass, true, clearColor, currentFrame});
+				vvh::ComBindPipeline({commandBuffer, pipeline, imageIndex, vk.m_swapChain, vk.m_renderPass, {}, {}, blendConstants, {}, currentFrame});
+				for( auto& set : objectSets ) {
+					vvh::ComRecordObject( {
+						.m_commandBuffer 	= commandBuffer,
+						.m_graphicsPipeline = pipeline,
+						.m_descriptorSets 	= { frameSet, set },
+						.m_type 			= type,
+						.m_mesh 			= mesh,
+						.m_currentFrame 	= currentFrame
+					});
+				}
+				vvh::ComEndRenderPass({commandBuffer});
+				vvh::ComEndCommandBuffer({commandBuffer});
+			});
+			vkResetCommandBuffer(commandBuffer, 0);
+			vkDestroyDescriptorPool(vk.m_device, pool, nullptr);
+			results.push_back(MakeResult("ComRecordObject", objects, iterations, ms, objects, "draws/s"));
+		}
+
+		vkFreeCommandBuffers(vk.m_device, vk.m_commandPool, 1, &commandBuffer);
+		vvh::BufDestroyBuffer({vk.m_device, vk.m_vmaAllocator, mesh.m_vertexBuffer, mesh.m_vertexBufferAllocation});
+		vvh::BufDestroyBuffer({vk.m_device, vk.m_vmaAllocator, mesh.m_indexBuffer, mesh.m_indexBufferAllocation});
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	void WriteJson(std::ostream& out, const Vulkan& vk, const std::vector<Result>& results) {
+		auto version = [](uint32_t v) {
+			return std::to_string(VK_VERSION_MAJOR(v)) + "." + std::to_string(VK_VERSION_MINOR(v)) + "." + std::to_string(VK_VERSION_PATCH(v));
+		};
+		out << "{\n"
+			<< "  \"device\": \"" << vk.m_properties.deviceName << "\",\n"
+			<< "  \"apiVersion\": \"" << version(vk.m_properties.apiVersion) << "\",\n"
+			<< "  \"driverVersion\": " << vk.m_properties.driverVersion << ",\n"
+			<< "  \"benchmarks\": [\n";
+		for( size_t i = 0; i < results.size(); ++i ) {
+			const Result& r = results[i];
+			out << "    { \"name\": \"" << r.m_name << "\", \"param\": " << r.m_param;
+			if( r.m_skipped.empty() ) {
+				out << ", \"iterations\": " << r.m_iterations << ", \"median_ms\": " << r.m_medianMs << ", \"min_ms\": " << r.m_minMs
+					<< ", \"rate\": " << r.m_rate << ", \"unit\": \"" << r.m_unit << "\"";
+			} else {
+				out << ", \"skipped\": \"" << r.m_skipped << "\"";
+			}
+			out << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n}\n";
+	}
+
+} // namespace bench
+
+
+int main(int argc, char* argv[]) {
+	std::string shader = "shaders/shader.spv", outPath = "bench_helpers.json";
+	uint32_t iterations = 10;
+	for( int i = 1; i < argc; ++i ) {
+		std::string arg = argv[i];
+		if( arg == "--shader" && i + 1 < argc ) shader = argv[++i];
+		else if( arg == "--out" && i + 1 < argc ) outPath = argv[++i];
+		else if( arg == "--quick" ) iterations = 3;
+	}
+
+	bench::Vulkan vk;
+	std::vector<bench::Result> results;
+	try {
+		bench::Init(vk);
+		bench::BenchVertexUpload(vk, iterations, results);
+		bench::BenchTextureUpload(vk, iterations, results);
+		bench::BenchTextureLoader(vk, iterations, results);
+
+		//a small texture and uniform buffer to write into the descriptor sets
+		std::vector<uint8_t> pixels(64 * 64 * 4, 255);
+		int size = 64;
+		size_t bytes = pixels.size();
+		vvh::Image texture{};
+		vvh::ImgCreateTextureImage({vk.m_physicalDevice, vk.m_device, vk.m_vmaAllocator, vk.m_graphicsQueue, vk.m_commandPool,
+			pixels.data(), size, size, bytes, texture});
+		texture.m_mapImageView = vvh::ImgCreateImageView2({vk.m_device, texture.m_mapImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT});
+		vvh::ImgCreateTextureSampler({vk.m_physicalDevice, vk.m_device, texture});
+		vvh::Buffer ubo;
+		vvh::BufCreateBuffers({vk.m_device, vk.m_vmaAllocator, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(vvh::BufferPerObjectTexture), ubo});
+		bench::Layouts layouts = bench::CreateLayouts(vk);
+
+		bench::BenchDescriptors(vk, layouts, texture, ubo, iterations, results);
+		bench::BenchPushDescriptors(vk, texture, ubo, iterations, results);
+		bench::BenchDescriptorBuffer(vk, texture, iterations, results);
+
+		if( std::filesystem::exists(shader) ) {
+			vvh::Pipeline pipeline{};
+			bench::BenchPipeline(vk, shader, layouts, iterations, results, pipeline);
+			bench::BenchPipelineBuilder(vk, shader, layouts, iterations, results);
+			bench::BenchPipelineRegistry(vk, shader, layouts, iterations, results);
+			bench::BenchRecording(vk, layouts, pipeline, iterations, results);
+			vkDestroyPipeline(vk.m_device, pipeline.m_pipeline, nullptr);
+			vkDestroyPipelineLayout(vk.m_device, pipeline.m_pipelineLayout, nullptr);
+		} else {
+			results.push_back({ .m_name = "RenCreateGraphicsPipeline", .m_param = 1, .m_skipped = "shader not found: " + shader });
+			results.push_back({ .m_name = "RenCreateGraphicsPipelineCached", .m_param = 1, .m_skipped = "shader not found: " + shader });
+			for( uint64_t count : { 64u, 256u } ) {
+				results.push_back({ .m_name = "PipelineBuilder", .m_param = count, .m_skipped = "shader not found: " + shader });
+			}
+			results.push_back({ .m_name = "PipelineRegistryCreate", .m_param = 64, .m_skipped = "shader not found: " + shader });
+			results.push_back({ .m_name = "PipelineRegistryGet", .m_param = 1'000'000, .m_skipped = "shader not found: " + shader });
+			for( uint64_t objects : { 1'000u, 10'000u, 100'000u } ) {
+				results.push_back({ .m_name = "ComRecordObject", .m_param = objects, .m_skipped = "shader not found: " + shader });
+			}
+		}
+
+		vkDestroyDescriptorSetLayout(vk.m_device, layouts.m_frame, nullptr);
+		vkDestroyDescriptorSetLayout(vk.m_device, layouts.m_object, nullptr);
+		vvh::BufDestroyBuffer2({vk.m_device, vk.m_vmaAllocator, ubo});
+		vkDestroySampler(vk.m_device, texture.m_mapSampler, nullptr);
+		vkDestroyImageView(vk.m_device, texture.m_mapImageView, nullptr);
+		vvh::ImgDestroyImage({vk.m_device, vk.m_vmaAllocator, texture.m_mapImage, texture.m_mapImageAllocation});
+		bench::Quit(vk);
+	} catch( const std::exception& e ) {
+		std::cerr << "bench_helpers: " << e.what() << "\n";
+		return 1;
+	}
+
+	std::ofstream out(outPath);
+	bench::WriteJson(out, vk, results);
+	std::cout << "wrote " << results.size() << " results to " << outPath << "\n";
+	return out ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+// Micro-benchmark for the channel swizzle used when reading back images, at 4K resolution.
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include "VHSwizzle2.h"
+
+using namespace vvh;
+
+static double Run(const char* name, SwizzleIsa isa, const SwizzlePattern& pattern, const std::vector<uint8_t>& src, std::vector<uint8_t>& dst, size_t pixels) {
+	const int iterations = 50;
+	double best = 1e30;
+	for( int i = 0; i < iterations; ++i ) {
+		auto start = std::chrono::high_resolution_clock::now();
+		SwzSwizzle(src.data(), dst.data(), pixels, pattern, isa);
+		auto end = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	std::cout << "  " << name << ": " << best << " ms, " << (src.size() / 1e6) / best << " GB/s\n";
+	return best;
+}
+
+int main() {
+	const size_t width = 3840, height = 2160, pixels = width * height;
+	std::vector<uint8_t> src(pixels * 4);
+	for( size_t i = 0; i < src.size(); ++i ) src[i] = (uint8_t)(i * 7 + 3);
+
+	std::vector<uint8_t> reference(pixels * 4), dst(pixels * 4);
+	SwizzleIsa best = SwzBestIsa();
+
+	struct Case { const char* m_name; SwizzlePattern m_pattern; } cases[] = {
+		{ "BGRA -> RGBA", { {2, 1, 0, 3}, 4 } },
+		{ "BGRA -> RGB", { {2, 1, 0, 3}, 3 } },
+		{ "RGBA -> RGB", { {0, 1, 2, 3}, 3 } },
+	};
+
+	int result = 0;
+	for( auto& c : cases ) {
+		std::cout << c.m_name << " (" << width << "x" << height << ")\n";
+
+		//the old path: memcpy out of staging memory, then swap channels in place
+		double naive = 1e30;
+		for( int i = 0; i < 50; ++i ) {
+			auto start = std::chrono::high_resolution_clock::now();
+			memcpy(dst.data(), src.data(), src.size());
+			for( size_t p = 0; p < pixels; ++p ) {
+				uint8_t px[4] = { dst[4 * p], dst[4 * p + 1], dst[4 * p + 2], dst[4 * p + 3] };
+				for( uint32_t ch = 0; ch < 4; ++ch ) dst[4 * p + ch] = px[c.m_pattern.m_source[ch]];
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			naive = std::min(naive, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		std::cout << "  memcpy + swap: " << naive << " ms\n";
+
+		double scalar = Run("scalar", SwizzleIsa::Scalar, c.m_pattern, src, reference, pixels);
+		size_t bytes = pixels * c.m_pattern.m_channels;
+
+		double fast = scalar;
+		if( best >= SwizzleIsa::SSSE3 ) {
+			fast = Run("ssse3", SwizzleIsa::SSSE3, c.m_pattern, src, dst, pixels);
+			if( memcmp(dst.data(), reference.data(), bytes) != 0 ) { std::cout << "  ssse3 MISMATCH\n"; result = 1; }
+		}
+		if( best >= SwizzleIsa::AVX2 ) {
+			fast = Run("avx2", SwizzleIsa::AVX2, c.m_pattern, src, dst, pixels);
+			if( memcmp(dst.data(), reference.data(), bytes) != 0 ) { std::cout << "  avx2 MISMATCH\n"; result = 1; }
+		}
+		std::cout << "  speedup vs memcpy + swap: " << naive / fast << "x\n";
+	}
+	return result;
+}
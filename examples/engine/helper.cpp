@@ -4,13 +4,40 @@
 namespace vhe {
 
     Object::~Object() {
-        vkDestroySampler(m_vulkan.m_device, m_texture.m_mapSampler, nullptr);
-        vkDestroyImageView(m_vulkan.m_device, m_texture.m_mapImageView, nullptr);
+        //the handles may be reused by later objects, so no cached set may still hand them out
+        for( auto buffer : m_uniformBuffers.m_uniformBuffers ) m_vulkan.m_descriptorSetCache.Evict((uint64_t)buffer);
+        if( m_texture.m_mapImageView != VK_NULL_HANDLE ) m_vulkan.m_descriptorSetCache.Evict((uint64_t)m_texture.m_mapImageView);
+        m_vulkan.m_samplerCache.Release(m_texture.m_mapSampler);
+        vkDestroyImageView(m_vulkan.m_device, m_texture.m_mapImageView, m_vulkan.m_pAllocator);
         vvh::ImgDestroyImage({m_vulkan.m_device, m_vulkan.m_vmaAllocator, m_texture.m_mapImage, m_texture.m_mapImageAllocation});
         vvh::BufDestroyBuffer({m_vulkan.m_device, m_vulkan.m_vmaAllocator, m_mesh.m_indexBuffer, m_mesh.m_indexBufferAllocation});
         vvh::BufDestroyBuffer({m_vulkan.m_device, m_vulkan.m_vmaAllocator, m_mesh.m_vertexBuffer, m_mesh.m_vertexBufferAllocation});
         vvh::BufDestroyBuffer2({m_vulkan.m_device, m_vulkan.m_vmaAllocator, m_uniformBuffers});
     };
+
+    static void UpdateObjectDescriptorSets(State& state, const std::shared_ptr<Object>& first) {
+        for( auto object = first; object; object = object->m_nextSibling ) {
+            auto& buffers = object->m_uniformBuffers.m_uniformBuffers;
+            if( state.vulkan.m_currentFrame < buffers.size() ) {
+                vvh::DescriptorSetKey key;
+                key.Buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, buffers[state.vulkan.m_currentFrame], 0, object->m_uniformBuffers.m_bufferSize);
+                if( object->m_texture.m_mapImageView != VK_NULL_HANDLE ) key.Texture(1, object->m_texture);
+                else { //the shader samples binding 1 anyway, and a key covering every binding can use the update template
+                    VkDescriptorImageInfo placeholder = state.vulkan.m_textureLoader.GetPlaceholder();
+                    key.Image(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, placeholder.imageView, placeholder.sampler);
+                }
+                object->m_descriptorSets.resize(MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+                object->m_descriptorSets[state.vulkan.m_currentFrame] = 
+                    state.vulkan.m_descriptorSetCache.Get(state.vulkan.m_descriptorSetLayoutPerObject, key);
+            }
+            UpdateObjectDescriptorSets(state, object->m_firstChild);
+        }
+    }
+
+    void UpdateObjectDescriptorSets(State& state) {
+        if( state.vulkan.m_descriptorSetLayoutPerObject == VK_NULL_HANDLE ) return;
+        UpdateObjectDescriptorSets(state, state.scene.m_root);
+    }
     
     auto VertexData::Type() -> std::string{
         std::string name;
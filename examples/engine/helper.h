@@ -99,11 +99,13 @@ namespace vhe {
 	    bool        m_running;
 		std::vector<std::unique_ptr<System>> m_systems;
 	    double      m_dt;
+	    uint64_t    m_maxFrames{0}; //stop after this many frames, 0...until the window is closed
+	    std::string m_tracePath{"trace.json"}; //CPU trace written on F12 and at quit, needs VVH_PROFILE
 	};
 
 	struct WindowState {
-	    int 		  m_width{0};
-	    int 		  m_height{0};
+	    int 		  m_width{800};
+	    int 		  m_height{600};
 	    std::string   m_windowName{""};
 	    glm::vec4 	  m_clearColor{0.45f, 0.55f, 0.60f, 1.00f};
 	    bool 		  m_isMinimized{false};
@@ -124,6 +126,29 @@ namespace vhe {
 	    VmaAllocator 	m_vmaAllocator;
 	    VkDebugUtilsMessengerEXT m_debugMessenger;
 	    VkAllocationCallbacks* m_pAllocator{nullptr};
+	    vvh::HostAllocator   m_hostAllocator;
+	    mutable vvh::SamplerCache m_samplerCache; //objects release their samplers through a const VulkanState&
+	    vvh::ReadbackQueue   m_readback;
+	    vvh::ThreadPool      m_threadPool;
+	    vvh::FrameCapture    m_capture{m_threadPool};
+	    vvh::TextureLoader   m_textureLoader{m_threadPool};
+	    vvh::GpuProfiler     m_gpuProfiler;
+	    vvh::PipelineCache   m_pipelineCache;
+	    vvh::ShaderLibrary   m_shaderLibrary;
+	    vvh::LayoutCache     m_layoutCache;
+	    vvh::DescriptorAllocator m_descriptorAllocator; //sets that live until Quit
+	    vvh::FrameDescriptors m_frameDescriptors;      //sets that live for one frame
+	    vvh::DescriptorWriter m_descriptorWriter;      //batched writes, update templates for layouts of m_layoutCache
+	    mutable vvh::DescriptorSetCache m_descriptorSetCache; //shared sets for equal bindings, from m_descriptorAllocator, objects evict through a const VulkanState&
+	    vvh::ShaderCompiler  m_shaderCompiler;
+	    vvh::PipelineBuilder m_pipelineBuilder;
+	    vvh::PipelineRegistry m_pipelineRegistry;
+	    vvh::ShaderReload    m_shaderReload;
+	    bool                m_captureFrames{false}; //write every presented frame to capture_<frame>.png
+	    bool                m_headless{false}; //no window and surface, render into offscreen images
+	    bool                m_pushDescriptors{false}; //VK_KHR_push_descriptor is enabled, see ComPushDescriptors
+	    bool                m_bufferDeviceAddress{false}; //bufferDeviceAddress is enabled, VMA is told in DevInitVMA
+	    uint64_t            m_frameNumber{0};
 	
 	    VkPhysicalDevice 			m_physicalDevice{VK_NULL_HANDLE};
 	    VkPhysicalDeviceFeatures 	m_physicalDeviceFeatures;
@@ -147,7 +172,8 @@ namespace vhe {
 
 	    vvh::Buffer          m_uniformBuffersPerFrame;
 	    vvh::Buffer          m_uniformBuffersLights;
-	    VkDescriptorSetLayout m_descriptorSetLayoutPerFrame;
+	    VkDescriptorSetLayout m_descriptorSetLayoutPerFrame; //owned by m_layoutCache
+	    VkDescriptorSetLayout m_descriptorSetLayoutPerObject{VK_NULL_HANDLE}; //owned by m_layoutCache, uniform buffer and texture
 	    vvh::DescriptorSet   m_descriptorSetPerFrame{0};
 	    VkRenderPass        m_renderPass;
 	    VkDescriptorPool    m_descriptorPool;
@@ -190,6 +216,10 @@ namespace vhe {
 	    SceneState scene;
 	};
 
+	/// @brief Fetch the descriptor sets of all objects for the frame in flight from the descriptor set cache: the
+	/// object's uniform buffer at binding 0 and its texture at binding 1. Objects with equal resources share a set.
+	void UpdateObjectDescriptorSets(State& state);
+
 	class System {
 		public:
 		System() {}
@@ -7,7 +7,14 @@
 namespace vhe {
 
 	void Init( State& state ) {
-	    vvh::SDL3Init( std::string("Vienna Vulkan Helper"), 800, 600, state.vulkan.m_instanceExtensions);
+	    VVH_ZONE("Init");
+	    VVH_TRACE_THREAD("main");
+	    state.vulkan.m_pAllocator = state.vulkan.m_hostAllocator.Callbacks();
+	    if( state.vulkan.m_headless ) {
+	        std::erase(state.vulkan.m_deviceExtensions, std::string(VK_KHR_SWAPCHAIN_EXTENSION_NAME));
+	    } else {
+	        vvh::SDL3Init( std::string("Vienna Vulkan Helper"), state.window.m_width, state.window.m_height, state.vulkan.m_instanceExtensions);
+	    }
 	    if (state.engine.m_debug) { state.vulkan.m_instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME); }
 
 	    volkInitialize();
@@ -18,17 +25,18 @@ namespace vhe {
 	            .m_name 				= state.engine.m_name, 
 	            .m_apiVersion 			= state.vulkan.m_apiVersionInstance, 
 	            .m_debug 				= state.engine.m_debug, 
-	            .m_instance 			= state.vulkan.m_instance 
+	            .m_instance 			= state.vulkan.m_instance,
+	            .m_pAllocator 			= state.vulkan.m_pAllocator
 	        }
 	    );
 	
 	    volkLoadInstance(state.vulkan.m_instance);
 
 	    if (state.engine.m_debug) {
-	        vvh::DevSetupDebugMessenger(state.vulkan.m_instance, state.vulkan.m_debugMessenger);
+	        vvh::DevSetupDebugMessenger(state.vulkan.m_instance, state.vulkan.m_debugMessenger, state.vulkan.m_pAllocator);
 	    }
 
-	    if (SDL_Vulkan_CreateSurface(state.window.m_window, state.vulkan.m_instance, nullptr, &state.vulkan.m_surface) == 0) {
+	    if (!state.vulkan.m_headless && SDL_Vulkan_CreateSurface(state.window.m_window, state.vulkan.m_instance, state.vulkan.m_pAllocator, &state.vulkan.m_surface) == 0) {
 	        printf("Failed to create Vulkan surface.\n");
 	    }
 
@@ -48,6 +56,11 @@ namespace vhe {
 
 	    state.vulkan.m_depthFormat = vvh::RenFindDepthFormat(state.vulkan.m_physicalDevice);    
 
+	    //optional, per-draw resources can be pushed instead of going through descriptor sets
+	    std::vector<std::string> pushDescriptor{ VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME };
+	    state.vulkan.m_pushDescriptors = vvh::DevCheckDeviceExtensionSupport({ state.vulkan.m_physicalDevice, pushDescriptor });
+	    if( state.vulkan.m_pushDescriptors ) state.vulkan.m_deviceExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
 	    vvh::DevCreateLogicalDevice( {
 			.m_surface 			= state.vulkan.m_surface, 
 			.m_physicalDevice 	= state.vulkan.m_physicalDevice, 
@@ -57,20 +70,56 @@ namespace vhe {
 			.m_queueFamilies 	= state.vulkan.m_queueFamilies, 
 			.m_device 			= state.vulkan.m_device, 
 			.m_graphicsQueue 	= state.vulkan.m_graphicsQueue, 
-			.m_presentQueue 	= state.vulkan.m_presentQueue
+			.m_presentQueue 	= state.vulkan.m_presentQueue,
+			.m_pAllocator 		= state.vulkan.m_pAllocator
 		});
 	
 	    volkLoadDevice(state.vulkan.m_device);
 	
 	    vvh::DevInitVMA(state.vulkan);  
-
-	    vvh::DevCreateSwapChain({
-			.m_window 			= state.window.m_window, 
-			.m_surface 			= state.vulkan.m_surface, 
-			.m_physicalDevice 	= state.vulkan.m_physicalDevice, 
-			.m_device 			= state.vulkan.m_device, 
-			.m_swapChain 		= state.vulkan.m_swapChain
-		});
+	    state.vulkan.m_pipelineCache.Init(state.vulkan.m_physicalDevice, state.vulkan.m_device, "pipeline_cache.bin", state.vulkan.m_pAllocator);
+	    state.vulkan.m_shaderLibrary.Init(state.vulkan.m_device, state.vulkan.m_pAllocator);
+	    state.vulkan.m_layoutCache.Init(state.vulkan.m_device, state.vulkan.m_pAllocator);
+	    state.vulkan.m_descriptorAllocator.Init(state.vulkan.m_device, &state.vulkan.m_layoutCache, 64, 
+	        vvh::DescriptorAllocator::DefaultRatios(), state.vulkan.m_pAllocator);
+	    state.vulkan.m_descriptorWriter.Init(state.vulkan.m_device, &state.vulkan.m_layoutCache, true, state.vulkan.m_pAllocator);
+	    state.vulkan.m_descriptorSetCache.Init(state.vulkan.m_device, state.vulkan.m_descriptorAllocator, 4096, MAX_FRAMES_IN_FLIGHT, 
+	        &state.vulkan.m_descriptorWriter);
+	    state.vulkan.m_frameDescriptors.Init(state.vulkan.m_device, &state.vulkan.m_layoutCache, MAX_FRAMES_IN_FLIGHT, 64, 
+	        state.vulkan.m_pAllocator);
+	    state.vulkan.m_shaderCompiler.Init(state.vulkan.m_threadPool, "shader_cache", { "shader" });
+	    state.vulkan.m_pipelineBuilder.Init(state.vulkan.m_threadPool, state.vulkan.m_shaderLibrary, state.vulkan.m_device, 
+	        state.vulkan.m_pipelineCache.Handle(), state.vulkan.m_pAllocator);
+	    state.vulkan.m_pipelineRegistry.Init(state.vulkan.m_device, state.vulkan.m_shaderLibrary, state.vulkan.m_pipelineCache.Handle(), 
+	        state.vulkan.m_pAllocator);
+	    state.vulkan.m_samplerCache.Init(state.vulkan.m_physicalDevice, state.vulkan.m_device, state.vulkan.m_pAllocator);
+	    state.vulkan.m_readback.Init(state.vulkan.m_device, state.vulkan.m_vmaAllocator);
+	    state.vulkan.m_textureLoader.Init(state.vulkan.m_physicalDevice, state.vulkan.m_device, state.vulkan.m_vmaAllocator, 
+	        state.vulkan.m_graphicsQueue, state.vulkan.m_queueFamilies.graphicsFamily.value(), state.vulkan.m_samplerCache, 
+	        64 << 20, state.vulkan.m_pAllocator);
+	    state.vulkan.m_gpuProfiler.Init(state.vulkan.m_physicalDevice, state.vulkan.m_device, 
+	        state.vulkan.m_queueFamilies.graphicsFamily.value(), false, 64, MAX_FRAMES_IN_FLIGHT, state.vulkan.m_pAllocator);
+
+	    if( state.vulkan.m_headless ) {
+	        VkExtent2D extent{ (uint32_t)state.window.m_width, (uint32_t)state.window.m_height };
+	        vvh::DevCreateOffscreenSwapChain({
+				.m_physicalDevice 	= state.vulkan.m_physicalDevice, 
+				.m_device 			= state.vulkan.m_device, 
+				.m_vmaAllocator 	= state.vulkan.m_vmaAllocator, 
+				.m_extent 			= extent, 
+				.m_swapChain 		= state.vulkan.m_swapChain,
+				.m_pAllocator 		= state.vulkan.m_pAllocator
+			});
+	    } else {
+	        vvh::DevCreateSwapChain({
+				.m_window 			= state.window.m_window, 
+				.m_surface 			= state.vulkan.m_surface, 
+				.m_physicalDevice 	= state.vulkan.m_physicalDevice, 
+				.m_device 			= state.vulkan.m_device, 
+				.m_swapChain 		= state.vulkan.m_swapChain,
+				.m_pAllocator 		= state.vulkan.m_pAllocator
+			});
+	    }
 		
 	    vvh::DevCreateImageViews(state.vulkan);
 
@@ -79,37 +128,77 @@ namespace vhe {
 			.m_device 		= state.vulkan.m_device, 
 			.m_swapChain 	= state.vulkan.m_swapChain, 
 			.m_clear 		= true, 
-			.m_renderPass 	= state.vulkan.m_renderPass
+			.m_renderPass 	= state.vulkan.m_renderPass,
+			.m_pAllocator 	= state.vulkan.m_pAllocator
 		});
 
-	    vvh::RenCreateDescriptorSetLayout( {
-			.m_device = state.vulkan.m_device, 
-			.m_bindings = {}, 
-			.m_descriptorSetLayout = state.vulkan.m_descriptorSetLayoutPerFrame 
-		});
-		
+	    std::string vertShaderPath = "shaders/shader.spv", fragShaderPath = "shaders/shader.spv";
+	    bool slang = std::filesystem::exists("shader/shader.slang");
+	    if( slang ) { //compile both stages in parallel, only if not cached
+	        auto spirv = state.vulkan.m_shaderCompiler.CompileAll({
+	            { "shader/shader.slang", "vertexMain", "vertex", {} },
+	            { "shader/shader.slang", "fragmentMain", "fragment", {} } });
+	        try {
+	            std::string vert = spirv[0].get(), frag = spirv[1].get();
+	            vertShaderPath = vert;
+	            fragShaderPath = frag;
+	        } catch( const std::exception& e ) {
+	            std::cerr << "shader compilation failed, using shaders/shader.spv: " << e.what() << "\n";
+	            slang = false;
+	        }
+	    }
+
+	    //set and pipeline layouts from the shaders' resources, owned by the layout cache
+	    vvh::ShaderLayout shaderLayout = state.vulkan.m_layoutCache.Create(
+	        vertShaderPath == fragShaderPath ? std::vector{ vertShaderPath } : std::vector{ vertShaderPath, fragShaderPath });
+	    state.vulkan.m_descriptorSetLayoutPerFrame = shaderLayout.m_setLayouts.empty() 
+	        ? state.vulkan.m_layoutCache.SetLayout({}) : shaderLayout.m_setLayouts[0];
+	    if( shaderLayout.m_setLayouts.size() > 1 ) state.vulkan.m_descriptorSetLayoutPerObject = shaderLayout.m_setLayouts[1];
+
 	    state.vulkan.m_pipelines.resize(1);
 	    vvh::RenCreateGraphicsPipeline({
 			.m_device = state.vulkan.m_device, 
 			.m_renderPass = state.vulkan.m_renderPass, 
-			.m_vertShaderPath = "shaders/shader.spv", 
-			.m_fragShaderPath = "shaders/shader.spv", 
+			.m_vertShaderPath = vertShaderPath, 
+			.m_fragShaderPath = fragShaderPath, 
 			.m_bindingDescription = {}, 
 			.m_attributeDescriptions = {},
-	        .m_descriptorSetLayouts = { state.vulkan.m_descriptorSetLayoutPerFrame }, 
+	        .m_descriptorSetLayouts = shaderLayout.m_setLayouts, 
 	        .m_specializationConstants = {}, 
-	        .m_pushConstantRanges = {}, 
+	        .m_pushConstantRanges = shaderLayout.m_pushConstantRanges, 
 	        .m_blendAttachments = {}, 
-	        .m_graphicsPipeline = state.vulkan.m_pipelines[0]
+	        .m_graphicsPipeline = state.vulkan.m_pipelines[0],
+	        .m_pAllocator = state.vulkan.m_pAllocator,
+	        .m_pipelineCache = state.vulkan.m_pipelineCache.Handle(),
+	        .m_vertShaderModule = state.vulkan.m_shaderLibrary.Load(vertShaderPath),
+	        .m_fragShaderModule = state.vulkan.m_shaderLibrary.Load(fragShaderPath),
+	        .m_pipelineLayout = shaderLayout.m_pipelineLayout
 		});
 
+	    //rebuild the pipeline when its shaders change, m_pipelines must not be resized after this
+	    vvh::PipelineDesc pipelineDesc{
+	        .m_renderPass = state.vulkan.m_renderPass,
+	        .m_vertShaderPath = vertShaderPath,
+	        .m_fragShaderPath = fragShaderPath,
+	        .m_descriptorSetLayouts = shaderLayout.m_setLayouts,
+	        .m_pushConstantRanges = shaderLayout.m_pushConstantRanges,
+	        .m_pipelineLayout = shaderLayout.m_pipelineLayout
+	    };
+	    state.vulkan.m_shaderReload.Init(state.vulkan.m_device, state.vulkan.m_shaderCompiler, state.vulkan.m_shaderLibrary, 
+	        state.vulkan.m_pipelineBuilder, { slang ? "shader" : "shaders" }, MAX_FRAMES_IN_FLIGHT, state.vulkan.m_pAllocator);
+	    if( slang ) {
+	        state.vulkan.m_shaderReload.Add(state.vulkan.m_pipelines[0], pipelineDesc, 
+	            { "shader/shader.slang", "vertexMain", "vertex", {} }, vvh::ShaderVariant{ "shader/shader.slang", "fragmentMain", "fragment", {} });
+	    } else state.vulkan.m_shaderReload.Add(state.vulkan.m_pipelines[0], pipelineDesc);
+
 	    state.vulkan.m_commandPools.resize(MAX_FRAMES_IN_FLIGHT);
 	    for( int i=0; i<MAX_FRAMES_IN_FLIGHT; ++i) {
 	        vvh::ComCreateCommandPool( {
 				.m_surface = state.vulkan.m_surface, 
 				.m_physicalDevice = state.vulkan.m_physicalDevice, 
 				.m_device = state.vulkan.m_device, 
-				.m_commandPool = state.vulkan.m_commandPools[i]
+				.m_commandPool = state.vulkan.m_commandPools[i],
+				.m_pAllocator = state.vulkan.m_pAllocator
 			});
 	    }
 	
@@ -136,7 +225,7 @@ namespace vhe {
 	            .m_image = image, 
 				.m_format = state.vulkan.m_swapChain.m_swapChainImageFormat, 
 	            .m_oldLayout = VK_IMAGE_LAYOUT_UNDEFINED, 
-				.m_newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+				.m_newLayout = state.vulkan.m_headless ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
 			});
 	    }
 
@@ -144,7 +233,8 @@ namespace vhe {
 	    vvh::RenCreateDescriptorPool( { 
 			.m_device = state.vulkan.m_device, 
 			.m_sizes = 1000, 
-			.m_descriptorPool = state.vulkan.m_descriptorPool 
+			.m_descriptorPool = state.vulkan.m_descriptorPool,
+			.m_pAllocator = state.vulkan.m_pAllocator
 		});
 	
 	    vvh::SynCreateSemaphores({
@@ -152,14 +242,16 @@ namespace vhe {
 			.m_imageAvailableSemaphores = state.vulkan.m_imageAvailableSemaphores, 
 			.m_renderFinishedSemaphores = state.vulkan.m_renderFinishedSemaphores, 
 			.m_size 					= 3, 
-			.m_intermediateSemaphores = state.vulkan.m_intermediateSemaphores
+			.m_intermediateSemaphores = state.vulkan.m_intermediateSemaphores,
+			.m_pAllocator 				= state.vulkan.m_pAllocator
 		});
 
-	    vvh::SynCreateFences( { state.vulkan.m_device, MAX_FRAMES_IN_FLIGHT, state.vulkan.m_fences });
+	    vvh::SynCreateFences( { state.vulkan.m_device, MAX_FRAMES_IN_FLIGHT, state.vulkan.m_fences, state.vulkan.m_pAllocator });
 	}
 
 
 	bool PrepareNextFrame(State& state) {
+	    VVH_ZONE("PrepareNextFrame");
 	    if(state.window.m_isMinimized) return false;
 
 	    state.vulkan.m_currentFrame = (state.vulkan.m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
@@ -167,6 +259,19 @@ namespace vhe {
 	    vvh::ComCreateCommandBuffers({state.vulkan.m_device, state.vulkan.m_commandPools[state.vulkan.m_currentFrame], state.vulkan.m_commandBuffers});
 
 	    vkWaitForFences(state.vulkan.m_device, 1, &state.vulkan.m_fences[state.vulkan.m_currentFrame], VK_TRUE, UINT64_MAX);
+	    state.vulkan.m_hostAllocator.NextFrame();
+	    //the fence just waited for was submitted MAX_FRAMES_IN_FLIGHT frames ago, that frame and all before it are done
+	    if( state.vulkan.m_frameNumber >= MAX_FRAMES_IN_FLIGHT ) state.vulkan.m_readback.Poll(state.vulkan.m_frameNumber - MAX_FRAMES_IN_FLIGHT + 1);
+	    state.vulkan.m_textureLoader.Update();
+	    state.vulkan.m_shaderReload.Update(state.vulkan.m_frameNumber);
+	    state.vulkan.m_frameDescriptors.BeginFrame(state.vulkan.m_currentFrame);
+	    state.vulkan.m_descriptorSetCache.BeginFrame(state.vulkan.m_frameNumber);
+	    UpdateObjectDescriptorSets(state); //sets unused for MAX_FRAMES_IN_FLIGHT frames are recycled, so fetch them every frame
+
+	    if( state.vulkan.m_headless ) { //offscreen images stay in VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+	        state.vulkan.m_imageIndex = (uint32_t)(state.vulkan.m_frameNumber % state.vulkan.m_swapChain.m_swapChainImages.size());
+	        return true;
+	    }
 
 	    VkResult result = vkAcquireNextImageKHR(state.vulkan.m_device, state.vulkan.m_swapChain.m_swapChain, UINT64_MAX,
 	                        state.vulkan.m_imageAvailableSemaphores[state.vulkan.m_currentFrame], VK_NULL_HANDLE, &state.vulkan.m_imageIndex);
@@ -190,7 +295,8 @@ namespace vhe {
 				.m_vmaAllocator 	= state.vulkan.m_vmaAllocator, 
 	            .m_swapChain 		= state.vulkan.m_swapChain, 
 				.m_depthImage 		= state.vulkan.m_depthImage, 
-				.m_renderPass 		= state.vulkan.m_renderPass
+				.m_renderPass 		= state.vulkan.m_renderPass,
+				.m_pAllocator 		= state.vulkan.m_pAllocator
 			});
 
 	        //m_engine.SendMsg( MsgWindowSize{} );
@@ -199,12 +305,16 @@ namespace vhe {
 	}
 
 	bool RecordNextFrame(State& state ) {
+	    VVH_ZONE("RecordNextFrame");
 	    if(state.window.m_isMinimized) return false;
 
 	    vkResetCommandBuffer(state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame],  0);
 
 		vvh::ComBeginCommandBuffer({state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame]});
+	    state.vulkan.m_gpuProfiler.BeginFrame(state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame], state.vulkan.m_currentFrame);
+	    uint32_t frameScope = state.vulkan.m_gpuProfiler.Begin(state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame], "frame");
 
+	    uint32_t renderPassScope = state.vulkan.m_gpuProfiler.Begin(state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame], "render pass");
 	    vvh::ComBeginRenderPass({
 			.m_commandBuffer= state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame], 
 			.m_imageIndex 	= state.vulkan.m_imageIndex, 
@@ -216,15 +326,36 @@ namespace vhe {
 		});
 
 	    vvh::ComEndRenderPass({state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame]});
+	    state.vulkan.m_gpuProfiler.End(state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame], renderPassScope);
+
+	    if( state.vulkan.m_captureFrames ) {
+	        vvh::GpuScope scope(state.vulkan.m_gpuProfiler, state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame], "capture");
+	        auto format = state.vulkan.m_swapChain.m_swapChainImageFormat;
+	        bool bgra = format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM;
+	        state.vulkan.m_capture.Capture(
+	            state.vulkan.m_readback, 
+	            state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame], 
+	            state.vulkan.m_swapChain.m_swapChainImages[state.vulkan.m_imageIndex], 
+	            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 
+	            state.vulkan.m_swapChain.m_swapChainExtent.width, 
+	            state.vulkan.m_swapChain.m_swapChainExtent.height, 
+	            state.vulkan.m_frameNumber, 
+	            bgra ? vvh::SwizzlePattern{ {2, 1, 0, 3}, 4 } : vvh::SwizzlePattern{}, 
+	            "capture_" + std::to_string(state.vulkan.m_frameNumber) + ".png");
+	    }
+	    ++state.vulkan.m_frameNumber;
+	    state.vulkan.m_gpuProfiler.End(state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame], frameScope);
 	    vvh::ComEndCommandBuffer({state.vulkan.m_commandBuffers[state.vulkan.m_currentFrame]});
 
 	    return true;
 	}
 
 	bool RenderNextFrame(State& state) {
+	    VVH_ZONE("RenderNextFrame");
 	    if(state.window.m_isMinimized) return false;
 	
 	    vvh::ComSubmitCommandBuffers(state.vulkan);
+	    if( state.vulkan.m_headless ) return true;
 
 	    vvh::ImgTransitionImageLayout2({
 			.m_device = state.vulkan.m_device, 
@@ -253,7 +384,8 @@ namespace vhe {
 				.m_vmaAllocator = state.vulkan.m_vmaAllocator, 
 	            .m_swapChain = state.vulkan.m_swapChain, 
 				.m_depthImage = state.vulkan.m_depthImage, 
-				.m_renderPass = state.vulkan.m_renderPass
+				.m_renderPass = state.vulkan.m_renderPass,
+				.m_pAllocator = state.vulkan.m_pAllocator
 			});
 
 	    } else assert(result == VK_SUCCESS);
@@ -261,10 +393,11 @@ namespace vhe {
 	}
 
 	void Step( State& state ) {
+	    VVH_ZONE("Step");
 	    SDL_Event event;
-	    SDL_PollEvent(&event);
+	    if( !state.vulkan.m_headless ) SDL_PollEvent(&event);
 
-	    while (SDL_PollEvent(&event)) {
+	    while (!state.vulkan.m_headless && SDL_PollEvent(&event)) {
 	        ImGui_ImplSDL3_ProcessEvent(&event); // Forward your event to backend
 	        switch (event.type) {
 	            case SDL_EVENT_QUIT:
@@ -281,65 +414,104 @@ namespace vhe {
 	                state.window.m_isMinimized = false;
 	                break;
 				default: {
+						if( event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_F12 ) VVH_TRACE_WRITE(state.engine.m_tracePath);
 						for( auto& system : state.engine.m_systems ) system->Event(state);
 					}
 					break;
 	        }
 	    }
 
-		for( auto& system : state.engine.m_systems ) system->Update(state);
+		for( auto& system : state.engine.m_systems ) {
+			VVH_ZONE("System::Update");
+			system->Update(state);
+		}
 
 	    if(!state.window.m_isMinimized) {
-	        ImGui_ImplVulkan_NewFrame();
-	        ImGui_ImplSDL3_NewFrame();
-	        ImGui::NewFrame();
+	        if( !state.vulkan.m_headless ) {
+	            ImGui_ImplVulkan_NewFrame();
+	            ImGui_ImplSDL3_NewFrame();
+	            ImGui::NewFrame();
 
-			for( auto& system : state.engine.m_systems ) system->ImGUI(state);
+				for( auto& system : state.engine.m_systems ) system->ImGUI(state);
 
-			ImGui::ShowDemoWindow(); // Show demo window! :)
+				ImGui::ShowDemoWindow(); // Show demo window! :)
+				state.vulkan.m_gpuProfiler.DrawImGui();
+	        }
 
 	        PrepareNextFrame(state);
 	        RecordNextFrame(state);
 	        RenderNextFrame(state);
 	    }
+	    state.vulkan.m_pipelineCache.Update();
+	    if( state.engine.m_maxFrames > 0 && state.vulkan.m_frameNumber >= state.engine.m_maxFrames ) state.engine.m_running = false;
 	}
 
 
 	void Quit(vhe::State& state ) {
 		vkDeviceWaitIdle(state.vulkan.m_device);
+		VVH_TRACE_WRITE(state.engine.m_tracePath);
 
 		state.scene.m_root = nullptr; //clear all objects
 
 		vvh::DevCleanupSwapChain(state.vulkan);
 	
-		for( auto& pipe : state.vulkan.m_pipelines) {
-			vkDestroyPipeline(state.vulkan.m_device, pipe.m_pipeline, nullptr);
-			vkDestroyPipelineLayout(state.vulkan.m_device, pipe.m_pipelineLayout, nullptr);
+		for( auto& pipe : state.vulkan.m_pipelines) { //their layouts belong to the layout cache
+			vkDestroyPipeline(state.vulkan.m_device, pipe.m_pipeline, state.vulkan.m_pAllocator);
 		}
 	
-		vkDestroyDescriptorPool(state.vulkan.m_device, state.vulkan.m_descriptorPool, nullptr);
-	
-		vkDestroyDescriptorSetLayout(state.vulkan.m_device, state.vulkan.m_descriptorSetLayoutPerFrame, nullptr);
+		vkDestroyDescriptorPool(state.vulkan.m_device, state.vulkan.m_descriptorPool, state.vulkan.m_pAllocator);
 	
 		for( auto& pool : state.vulkan.m_commandPools) {
-			vkDestroyCommandPool(state.vulkan.m_device, pool, nullptr);
+			vkDestroyCommandPool(state.vulkan.m_device, pool, state.vulkan.m_pAllocator);
 		}
 	
-		vkDestroyRenderPass(state.vulkan.m_device, state.vulkan.m_renderPass, nullptr);
+		vkDestroyRenderPass(state.vulkan.m_device, state.vulkan.m_renderPass, state.vulkan.m_pAllocator);
+		state.vulkan.m_textureLoader.Destroy();
+		state.vulkan.m_gpuProfiler.Destroy();
+		state.vulkan.m_shaderReload.Destroy();
+		state.vulkan.m_pipelineBuilder.Destroy();
+		state.vulkan.m_pipelineRegistry.Destroy();
+		state.vulkan.m_shaderLibrary.Destroy();
+		state.vulkan.m_frameDescriptors.Destroy();
+		if (state.engine.m_debug) { //before Destroy, which clears the cached set and buffer counts
+			state.vulkan.m_descriptorSetCache.PrintStatistics();
+			state.vulkan.m_descriptorWriter.PrintStatistics();
+			state.vulkan.m_descriptorAllocator.PrintStatistics();
+		}
+		state.vulkan.m_descriptorSetCache.Destroy();
+		state.vulkan.m_descriptorWriter.Destroy();
+		state.vulkan.m_descriptorAllocator.Destroy();
+		state.vulkan.m_layoutCache.Destroy();
+		state.vulkan.m_pipelineCache.Destroy();
+		state.vulkan.m_samplerCache.Destroy();
+		state.vulkan.m_readback.Poll(state.vulkan.m_frameNumber);	//the device is idle, every submitted frame is done
+		state.vulkan.m_readback.Destroy();
+		state.vulkan.m_capture.Flush();
 		vvh::SynDestroyFences(state.vulkan);
 		vvh::SynDestroySemaphores(state.vulkan);
 		vmaDestroyAllocator(state.vulkan.m_vmaAllocator);
-		vkDestroyDevice(state.vulkan.m_device, nullptr);
-		vkDestroySurfaceKHR(state.vulkan.m_instance, state.vulkan.m_surface, nullptr);
+		vkDestroyDevice(state.vulkan.m_device, state.vulkan.m_pAllocator);
+		if (state.vulkan.m_surface != VK_NULL_HANDLE) {
+			vkDestroySurfaceKHR(state.vulkan.m_instance, state.vulkan.m_surface, state.vulkan.m_pAllocator);
+		}
 	
 		if (state.engine.m_debug) {
 			vvh::DevDestroyDebugUtilsMessengerEXT(state.vulkan);
 		}
 	
-		vkDestroyInstance(state.vulkan.m_instance, nullptr);
+		if (state.engine.m_debug) {
+			state.vulkan.m_hostAllocator.PrintStatistics();
+			state.vulkan.m_capture.PrintStatistics();
+			state.vulkan.m_textureLoader.PrintStatistics();
+			state.vulkan.m_pipelineRegistry.PrintStatistics();
+		}
+
+		vkDestroyInstance(state.vulkan.m_instance, state.vulkan.m_pAllocator);
 	
-		SDL_DestroyWindow(state.window.m_window);
-		SDL_Quit();
+		if (!state.vulkan.m_headless) {
+			SDL_DestroyWindow(state.window.m_window);
+			SDL_Quit();
+		}
 	}
 
 
@@ -377,11 +549,21 @@ class MyGame : public vhe::System {
 };
 
 
-int main() {
+int main(int argc, char* argv[]) {
 	using namespace vhe; 
 
     vhe::State state;
 
+    //--headless renders into offscreen images without a window, --frames n stops after n frames, --capture writes them to disk,
+    //--trace file sets where the CPU trace is written
+    for( int i = 1; i < argc; ++i ) {
+        std::string arg = argv[i];
+        if( arg == "--headless" ) state.vulkan.m_headless = true;
+        else if( arg == "--capture" ) state.vulkan.m_captureFrames = true;
+        else if( arg == "--frames" && i + 1 < argc ) state.engine.m_maxFrames = std::stoull(argv[++i]);
+        else if( arg == "--trace" && i + 1 < argc ) state.engine.m_tracePath = argv[++i];
+    }
+
     #ifdef NDEBUG
         state.engine.m_debug = false;
     #else
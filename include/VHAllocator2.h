@@ -0,0 +1,262 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Host memory allocator that can be handed to Vulkan as VkAllocationCallbacks.
+	// Small blocks come from size class free lists, command scope blocks (which only live for the
+	// duration of a single vk* call) come from a scratch arena that is rewound once per frame.
+	// Statistics are kept per VkSystemAllocationScope.
+
+	struct AllocScopeStatistics {
+		std::atomic<uint64_t> m_allocations{0};
+		std::atomic<uint64_t> m_reallocations{0};
+		std::atomic<uint64_t> m_frees{0};
+		std::atomic<uint64_t> m_bytesTotal{0};			//sum of all bytes ever allocated
+		std::atomic<int64_t>  m_bytesInUse{0};
+		std::atomic<int64_t>  m_bytesPeak{0};
+		std::atomic<uint64_t> m_internalAllocations{0};	//driver notifications, memory not owned by us
+		std::atomic<int64_t>  m_internalBytesInUse{0};
+	};
+
+	class HostAllocator {
+
+		static constexpr uint32_t c_scopes 	= VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+		static constexpr uint32_t c_classes 	= 8;			//32, 64, ..., 4096 bytes including header
+		static constexpr size_t   c_minClass 	= 32;
+		static constexpr size_t   c_chunkSize 	= 64 * 1024;
+		static constexpr size_t   c_headerSize = 16;
+		static constexpr size_t   c_alignment 	= 16;			//alignment guaranteed by pool and arena
+
+		enum Origin : uint16_t { ORIGIN_HEAP = 0xFFFF, ORIGIN_ARENA = 0xFFFE };
+
+		struct BlockHeader {
+			uint64_t m_size;		//user size
+			uint16_t m_origin;		//size class index, ORIGIN_HEAP or ORIGIN_ARENA
+			uint16_t m_scope;
+			uint32_t m_offset;		//distance from the raw allocation to the user pointer
+		};
+		static_assert(sizeof(BlockHeader) == c_headerSize);
+
+		struct FreeNode { FreeNode* m_next; };
+
+		struct SizeClass {
+			std::mutex 			m_mutex;
+			FreeNode* 			m_free{nullptr};
+			std::vector<void*> 	m_chunks;
+		};
+
+	public:
+		HostAllocator(size_t arenaSize = 4 * 1024 * 1024) : m_arenaSize{arenaSize} {
+			m_arena = (char*)std::malloc(m_arenaSize);
+			m_callbacks.pUserData 				= this;
+			m_callbacks.pfnAllocation 			= &HostAllocator::Allocation;
+			m_callbacks.pfnReallocation 		= &HostAllocator::Reallocation;
+			m_callbacks.pfnFree 				= &HostAllocator::Free;
+			m_callbacks.pfnInternalAllocation 	= &HostAllocator::InternalAllocation;
+			m_callbacks.pfnInternalFree 		= &HostAllocator::InternalFree;
+		}
+
+		~HostAllocator() {
+			for( auto& sc : m_classes ) { for( auto chunk : sc.m_chunks ) std::free(chunk); }
+			std::free(m_arena);
+		}
+
+		HostAllocator(const HostAllocator&) = delete;
+		HostAllocator& operator=(const HostAllocator&) = delete;
+
+		/// @brief Callbacks to pass as pAllocator to vkCreate* / vkDestroy* calls.
+		auto Callbacks() -> VkAllocationCallbacks* { return &m_callbacks; }
+
+		/// @brief Rewind the scratch arena, call once per frame. The arena is only rewound if all command scope blocks
+		/// have been returned. Other threads may allocate meanwhile, e.g. pipeline builds on workers: if one takes
+		/// a block after the check, the offset has moved and the rewind is skipped until the next frame.
+		void NextFrame() {
+			size_t offset = m_arenaOffset.load();
+			if( m_arenaLive.load() == 0 && m_arenaOffset.compare_exchange_strong(offset, 0) ) {
+				m_arenaHighWater = std::max(m_arenaHighWater, std::min(m_arenaSize, offset));
+			}
+		}
+
+		auto Statistics(VkSystemAllocationScope scope) const -> const AllocScopeStatistics& { return m_stats[scope]; }
+
+		void PrintStatistics(std::ostream& out = std::cout) const {
+			static const char* names[c_scopes] = { "command", "object", "cache", "device", "instance" };
+			out << "Host allocations per scope:\n";
+			for( uint32_t i = 0; i < c_scopes; ++i ) {
+				auto& s = m_stats[i];
+				out << "  " << std::setw(8) << names[i]
+					<< " allocs: " 		<< std::setw(8) << s.m_allocations
+					<< " reallocs: " 	<< std::setw(6) << s.m_reallocations
+					<< " frees: " 		<< std::setw(8) << s.m_frees
+					<< " total: " 		<< std::setw(10) << s.m_bytesTotal
+					<< " in use: " 		<< std::setw(10) << s.m_bytesInUse
+					<< " peak: " 		<< std::setw(10) << s.m_bytesPeak
+					<< " internal: " 	<< s.m_internalAllocations << "/" << s.m_internalBytesInUse << "\n";
+			}
+			out << "  arena high water: " << std::max(m_arenaHighWater, std::min(m_arenaSize, m_arenaOffset.load())) << " of " << m_arenaSize << " bytes\n";
+		}
+
+	private:
+
+		static auto ClassIndex(size_t size) -> uint32_t {
+			size_t total = size + c_headerSize;
+			uint32_t idx = 0;
+			for( size_t cs = c_minClass; cs < total; cs <<= 1 ) ++idx;
+			return idx;
+		}
+
+		static auto ClassSize(uint32_t idx) -> size_t { return c_minClass << idx; }
+
+		static auto Header(void* p) -> BlockHeader* { return (BlockHeader*)((char*)p - c_headerSize); }
+
+		auto PoolAllocate(uint32_t idx) -> void* {
+			auto& sc = m_classes[idx];
+			std::lock_guard<std::mutex> lock(sc.m_mutex);
+			if( !sc.m_free ) {
+				char* chunk = (char*)std::malloc(c_chunkSize);
+				if( !chunk ) return nullptr;
+				sc.m_chunks.push_back(chunk);
+				size_t cs = ClassSize(idx);
+				for( size_t off = c_chunkSize - cs; ; off -= cs ) {
+					FreeNode* node = (FreeNode*)(chunk + off);
+					node->m_next = sc.m_free;
+					sc.m_free = node;
+					if( off == 0 ) break;
+				}
+			}
+			FreeNode* node = sc.m_free;
+			sc.m_free = node->m_next;
+			return node;
+		}
+
+		void PoolFree(uint32_t idx, void* raw) {
+			auto& sc = m_classes[idx];
+			std::lock_guard<std::mutex> lock(sc.m_mutex);
+			FreeNode* node = (FreeNode*)raw;
+			node->m_next = sc.m_free;
+			sc.m_free = node;
+		}
+
+		auto ArenaAllocate(size_t size) -> void* {
+			size_t total = (size + c_headerSize + c_alignment - 1) & ~(c_alignment - 1);
+			m_arenaLive.fetch_add(1);	//sequentially consistent, NextFrame relies on the order of these two
+			size_t off = m_arenaOffset.fetch_add(total);
+			if( off + total > m_arenaSize ) {		//arena exhausted, caller falls back to pool/heap
+				m_arenaLive.fetch_sub(1, std::memory_order_acq_rel);
+				return nullptr;
+			}
+			return m_arena + off;
+		}
+
+		auto DoAllocate(size_t size, size_t alignment, VkSystemAllocationScope scope) -> void* {
+			char* raw = nullptr;
+			uint16_t origin = ORIGIN_HEAP;
+			uint32_t offset = c_headerSize;
+
+			if( alignment <= c_alignment ) {
+				if( scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND && m_arena && (raw = (char*)ArenaAllocate(size)) ) {
+					origin = ORIGIN_ARENA;
+				} else if( uint32_t idx = ClassIndex(size); idx < c_classes ) {
+					raw = (char*)PoolAllocate(idx);
+					origin = (uint16_t)idx;
+				}
+			}
+
+			if( !raw ) {
+				alignment = std::max(alignment, c_alignment);
+				raw = (char*)std::malloc(size + alignment + c_headerSize);
+				if( !raw ) return nullptr;
+				uintptr_t user = ((uintptr_t)raw + c_headerSize + alignment - 1) & ~(uintptr_t)(alignment - 1);
+				offset = (uint32_t)(user - (uintptr_t)raw);
+				origin = ORIGIN_HEAP;
+			}
+
+			void* user = raw + offset;
+			BlockHeader* header = Header(user);
+			header->m_size 		= size;
+			header->m_origin 	= origin;
+			header->m_scope 	= (uint16_t)scope;
+			header->m_offset 	= offset;
+
+			auto& s = m_stats[scope];
+			s.m_allocations.fetch_add(1, std::memory_order_relaxed);
+			s.m_bytesTotal.fetch_add(size, std::memory_order_relaxed);
+			int64_t inUse = s.m_bytesInUse.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size;
+			int64_t peak = s.m_bytesPeak.load(std::memory_order_relaxed);
+			while( inUse > peak && !s.m_bytesPeak.compare_exchange_weak(peak, inUse, std::memory_order_relaxed) ) {}
+			return user;
+		}
+
+		void DoFree(void* user) {
+			BlockHeader* header = Header(user);
+			auto& s = m_stats[header->m_scope];
+			s.m_frees.fetch_add(1, std::memory_order_relaxed);
+			s.m_bytesInUse.fetch_sub((int64_t)header->m_size, std::memory_order_relaxed);
+
+			char* raw = (char*)user - header->m_offset;
+			if( header->m_origin == ORIGIN_ARENA ) m_arenaLive.fetch_sub(1, std::memory_order_acq_rel);
+			else if( header->m_origin == ORIGIN_HEAP ) std::free(raw);
+			else PoolFree(header->m_origin, raw);
+		}
+
+		//-------------------------------------------------------------------------------------
+		// Vulkan callbacks
+
+		static VKAPI_ATTR void* VKAPI_CALL Allocation(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+			if( size == 0 ) return nullptr;
+			return ((HostAllocator*)pUserData)->DoAllocate(size, alignment, scope);
+		}
+
+		static VKAPI_ATTR void* VKAPI_CALL Reallocation(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+			auto self = (HostAllocator*)pUserData;
+			if( !pOriginal ) return Allocation(pUserData, size, alignment, scope);
+			if( size == 0 ) { self->DoFree(pOriginal); return nullptr; }
+
+			BlockHeader* header = Header(pOriginal);
+			if( header->m_origin < c_classes && size + c_headerSize <= ClassSize(header->m_origin) && header->m_scope == scope ) {
+				auto& s = self->m_stats[scope];
+				s.m_bytesInUse.fetch_add((int64_t)size - (int64_t)header->m_size, std::memory_order_relaxed);
+				s.m_reallocations.fetch_add(1, std::memory_order_relaxed);
+				header->m_size = size;	//still fits into its block
+				return pOriginal;
+			}
+
+			void* p = self->DoAllocate(size, alignment, scope);
+			if( !p ) return nullptr;
+			memcpy(p, pOriginal, std::min((size_t)header->m_size, size));
+			self->DoFree(pOriginal);
+			self->m_stats[scope].m_reallocations.fetch_add(1, std::memory_order_relaxed);
+			return p;
+		}
+
+		static VKAPI_ATTR void VKAPI_CALL Free(void* pUserData, void* pMemory) {
+			if( pMemory ) ((HostAllocator*)pUserData)->DoFree(pMemory);
+		}
+
+		static VKAPI_ATTR void VKAPI_CALL InternalAllocation(void* pUserData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+			auto& s = ((HostAllocator*)pUserData)->m_stats[scope];
+			s.m_internalAllocations.fetch_add(1, std::memory_order_relaxed);
+			s.m_internalBytesInUse.fetch_add((int64_t)size, std::memory_order_relaxed);
+		}
+
+		static VKAPI_ATTR void VKAPI_CALL InternalFree(void* pUserData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+			((HostAllocator*)pUserData)->m_stats[scope].m_internalBytesInUse.fetch_sub((int64_t)size, std::memory_order_relaxed);
+		}
+
+		VkAllocationCallbacks 				m_callbacks{};
+		std::array<SizeClass, c_classes> 	m_classes;
+		std::array<AllocScopeStatistics, c_scopes> m_stats;
+
+		char* 					m_arena{nullptr};
+		size_t 					m_arenaSize;
+		std::atomic<size_t> 	m_arenaOffset{0};
+		std::atomic<int64_t> 	m_arenaLive{0};
+		size_t 					m_arenaHighWater{0};
+	};
+
+} // namespace vh
@@ -28,6 +28,7 @@ namespace vvh {
 
 	template<typename T = BufCreateBufferInfo>
 	inline void BufCreateBuffer(T&& info) {
+		VVH_ZONE_FUNCTION;
 		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
 		bufferInfo.size = info.m_size;
 		bufferInfo.usage = info.m_usageFlags;
@@ -51,6 +52,7 @@ namespace vvh {
     
 	template<typename T = BufCreateBuffersInfo>
 	inline void BufCreateBuffers(T&& info) {
+		VVH_ZONE_FUNCTION;
 
 		info.m_buffer.m_bufferSize = info.m_size;
 		info.m_buffer.m_uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
@@ -84,6 +86,7 @@ namespace vvh {
 
 	template<typename T = BufDestroyBufferinfo>
 	inline void BufDestroyBuffer(T&& info) {
+        VVH_ZONE_FUNCTION;
         vmaDestroyBuffer(info.m_vmaAllocator, info.m_buffer, info.m_allocation);
     }
 
@@ -97,6 +100,7 @@ namespace vvh {
 
 	template<typename T = BufDestroyBuffer2Info>
 	inline void BufDestroyBuffer2(T&& info) {
+		VVH_ZONE_FUNCTION;
 		for (size_t i = 0; i < info.m_buffers.m_uniformBuffers.size(); i++) {
 			vmaDestroyBuffer(info.m_vmaAllocator, info.m_buffers.m_uniformBuffers[i], info.m_buffers.m_uniformBuffersAllocation[i]);
 		}
@@ -114,6 +118,7 @@ namespace vvh {
 
 	template<typename T = BufCopyBufferInfo>
 	inline void BufCopyBuffer(T&& info) {
+        VVH_ZONE_FUNCTION;
         VkCommandBuffer commandBuffer = ComBeginSingleTimeCommands(info);
         VkBufferCopy copyRegion{};
         copyRegion.size = info.m_size;
@@ -135,6 +140,7 @@ namespace vvh {
 
 	template<typename T = BufCopyBufferToImageInfo>
 	void BufCopyBufferToImage(T&& info) {
+		VVH_ZONE_FUNCTION;
 		VkCommandBuffer commandBuffer = ComBeginSingleTimeCommands(info);
 		VkBufferImageCopy region{};
 		region.bufferOffset = 0;
@@ -172,6 +178,7 @@ namespace vvh {
 
 	template<typename T = BufCopyImageToBufferInfo>
 	inline void BufCopyImageToBuffer(T&& info) {
+		VVH_ZONE_FUNCTION;
 		VkCommandBuffer commandBuffer = ComBeginSingleTimeCommands(info);
 		vkCmdCopyImageToBuffer(commandBuffer, info.m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, info.m_buffer, 
 			(uint32_t)info.m_regions.size(), info.m_regions.data());
@@ -194,6 +201,7 @@ namespace vvh {
 
 	template<typename T = BufCopyImageToBuffer2Info>
 	inline void BufCopyImageToBuffer2(T&& info) {
+		VVH_ZONE_FUNCTION;
 		std::vector<VkBufferImageCopy> regions;
 
 		VkBufferImageCopy region = {};
@@ -234,6 +242,7 @@ namespace vvh {
 
 	template<typename T = BufCreateVertexBufferInfo>
 	void BufCreateVertexBuffer(T&& info) {
+		VVH_ZONE_FUNCTION;
 
 		VkDeviceSize bufferSize = info.m_mesh.m_verticesData.getSize();
 
@@ -281,6 +290,7 @@ namespace vvh {
 
 	template<typename T = BufCreateIndexBufferinfo>
 	void BufCreateIndexBuffer(T&& info) {
+		VVH_ZONE_FUNCTION;
 
 		VkDeviceSize bufferSize = sizeof(info.m_mesh.m_indices[0]) * info.m_mesh.m_indices.size();
 
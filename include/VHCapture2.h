@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <filesystem>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Writes captured frames to disk as PNG (stb_image_write) or raw pixels on a thread pool.
+	// At most m_maxInFlight frames are queued or being encoded. Further frames are dropped
+	// instead of blocking the render thread, so rendering never waits for the encoder.
+
+	class FrameCapture {
+	public:
+		enum class Format { PNG, RAW };
+
+		struct Statistics {
+			uint64_t 	m_submitted{0};
+			uint64_t 	m_encoded{0};
+			uint64_t 	m_dropped{0};		//the queue was full
+			uint64_t 	m_failed{0};		//the file could not be written
+			uint64_t 	m_pixelBytes{0};	//uncompressed bytes of all encoded frames
+			uint64_t 	m_fileBytes{0};
+			double 		m_encodeSeconds{0};	//summed over all workers
+			uint32_t 	m_queueDepth{0};
+			uint32_t 	m_maxQueueDepth{0};
+		};
+
+		FrameCapture(ThreadPool& threadPool, uint32_t maxInFlight = 8, Format format = Format::PNG)
+			: m_threadPool{threadPool}, m_maxInFlight{maxInFlight}, m_format{format} {}
+
+		~FrameCapture() { Flush(); }
+
+		/// @brief Queue tightly packed 8 bit pixels for writing. Returns false and drops the frame if the queue is full.
+		bool Submit(std::vector<uint8_t>&& pixels, uint32_t width, uint32_t height, uint32_t channels, std::string filename) {
+			uint32_t depth = m_inFlight.load();
+			do {
+				if( depth >= m_maxInFlight ) { ++m_dropped; return false; }
+			} while( !m_inFlight.compare_exchange_weak(depth, depth + 1) );
+
+			uint32_t maxDepth = m_maxDepth.load();
+			while( depth + 1 > maxDepth && !m_maxDepth.compare_exchange_weak(maxDepth, depth + 1) );
+			if( m_submitted++ == 0 ) m_start = std::chrono::steady_clock::now();
+
+			m_threadPool.Enqueue([this, pixels = std::move(pixels), width, height, channels, filename = std::move(filename)] {
+				Encode(pixels, width, height, channels, filename);
+				std::lock_guard<std::mutex> lock(m_mutex);
+				--m_inFlight;
+				m_condition.notify_all();
+			});
+			return true;
+		}
+
+		/// @brief Read back an image with the readback queue and write it once it arrives. The swizzle is done
+		/// in ReadbackQueue::Poll(), encoding on the thread pool. Returns false if the frame was dropped.
+		bool Capture(ReadbackQueue& readback, VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout,
+					uint32_t width, uint32_t height, uint64_t frameNumber, const SwizzlePattern& pattern, std::string filename) {
+			if( m_inFlight.load() >= m_maxInFlight ) { ++m_dropped; return false; }
+			return readback.Record(commandBuffer, image, layout, width, height, frameNumber,
+				[this, pattern, filename = std::move(filename)](const uint8_t* data, uint32_t w, uint32_t h, VkDeviceSize) {
+					std::vector<uint8_t> pixels((size_t)w * h * pattern.m_channels);
+					SwzSwizzle(data, pixels.data(), (size_t)w * h, pattern);
+					Submit(std::move(pixels), w, h, pattern.m_channels, filename);
+				});
+		}
+
+		/// @brief Wait until all queued frames have been written, e.g. at the end of an offline batch.
+		void Flush() {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] { return m_inFlight.load() == 0; });
+		}
+
+		auto GetStatistics() -> Statistics {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			Statistics stats = m_statistics;
+			stats.m_submitted = m_submitted.load();
+			stats.m_dropped = m_dropped.load();
+			stats.m_queueDepth = m_inFlight.load();
+			stats.m_maxQueueDepth = m_maxDepth.load();
+			return stats;
+		}
+
+		void PrintStatistics(std::ostream& out = std::cout) {
+			Statistics s = GetStatistics();
+			double wall = m_submitted.load() > 0 ? std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count() : 0.0;
+			out << "Frame capture:\n"
+				<< "  submitted: " << s.m_submitted << " encoded: " << s.m_encoded << " dropped: " << s.m_dropped << " failed: " << s.m_failed << "\n"
+				<< "  queue depth: " << s.m_queueDepth << " max: " << s.m_maxQueueDepth << " of " << m_maxInFlight << "\n"
+				<< std::fixed << std::setprecision(2)
+				<< "  throughput: " << (wall > 0 ? s.m_encoded / wall : 0.0) << " frames/s, "
+				<< (wall > 0 ? s.m_pixelBytes / wall / 1e6 : 0.0) << " MB/s pixels\n"
+				<< "  encode time: " << (s.m_encoded > 0 ? 1000.0 * s.m_encodeSeconds / s.m_encoded : 0.0) << " ms/frame on "
+				<< m_threadPool.Size() << " threads, files: " << s.m_fileBytes / 1e6 << " MB\n"
+				<< std::defaultfloat;
+		}
+
+	private:
+		void Encode(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, uint32_t channels, const std::string& filename) {
+			auto start = std::chrono::steady_clock::now();
+			bool ok = false;
+			uint64_t fileBytes = 0;
+			if( m_format == Format::PNG ) {
+				ok = stbi_write_png(filename.c_str(), (int)width, (int)height, (int)channels, pixels.data(), (int)(width * channels)) != 0;
+				std::error_code error;
+				if( ok ) fileBytes = std::filesystem::file_size(filename, error);
+			} else {
+				std::ofstream file(filename, std::ios::binary);
+				ok = (bool)file.write((const char*)pixels.data(), pixels.size());
+				fileBytes = pixels.size();
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if( !ok ) { ++m_statistics.m_failed; return; }
+			++m_statistics.m_encoded;
+			m_statistics.m_pixelBytes += pixels.size();
+			m_statistics.m_fileBytes += fileBytes;
+			m_statistics.m_encodeSeconds += seconds;
+		}
+
+		ThreadPool& 			m_threadPool;
+		const uint32_t 			m_maxInFlight;
+		const Format 			m_format;
+		std::atomic<uint32_t> 	m_inFlight{0};
+		std::atomic<uint32_t> 	m_maxDepth{0};
+		std::atomic<uint64_t> 	m_submitted{0};
+		std::atomic<uint64_t> 	m_dropped{0};
+		std::chrono::steady_clock::time_point m_start;
+		std::mutex 				m_mutex;
+		std::condition_variable m_condition;
+		Statistics 				m_statistics;
+	};
+
+} // namespace vvh
+
@@ -3,16 +3,19 @@
 namespace vvh {
 
 	//---------------------------------------------------------------------------------------------
+	/// m_surface may be VK_NULL_HANDLE in headless mode.
 
     struct ComCreateCommandPoolinfo {
 		const VkSurfaceKHR& 	m_surface;
 		const VkPhysicalDevice& m_physicalDevice;
 		const VkDevice& 		m_device;
 		VkCommandPool& 			m_commandPool;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = ComCreateCommandPoolinfo>
 	inline void ComCreateCommandPool(T&& info) {
+        VVH_ZONE_FUNCTION;
         QueueFamilyIndices queueFamilyIndices = DevFindQueueFamilies({ info.m_physicalDevice, info.m_surface });
 
         VkCommandPoolCreateInfo poolInfo{};
@@ -20,7 +23,7 @@ namespace vvh {
         poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
         poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
 
-        if (vkCreateCommandPool(info.m_device, &poolInfo, nullptr, &info.m_commandPool) != VK_SUCCESS) {
+        if (vkCreateCommandPool(info.m_device, &poolInfo, info.m_pAllocator, &info.m_commandPool) != VK_SUCCESS) {
             throw std::runtime_error("failed to create graphics command pool!");
         }
     }
@@ -34,6 +37,7 @@ namespace vvh {
 
 	template<typename T = ComBeginSingleTimeCommandsInfo>
 	inline auto ComBeginSingleTimeCommands(T&& info) -> VkCommandBuffer {
+        VVH_ZONE_FUNCTION;
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -57,6 +61,7 @@ namespace vvh {
 	
 	template<typename T>
 	inline void ComEndSingleTimeCommands(T&& info) {
+        VVH_ZONE_FUNCTION;
         vkEndCommandBuffer(info.m_commandBuffer);
 
         VkSubmitInfo submitInfo{};
@@ -80,6 +85,7 @@ namespace vvh {
 
 	template<typename T = ComCreateCommandBuffersInfo>
     inline void ComCreateCommandBuffers(T&& info) {
+        VVH_ZONE_FUNCTION;
         if(info.m_commandBuffers.size() == 0) info.m_commandBuffers.resize(2);
 
         VkCommandBufferAllocateInfo allocInfo{};
@@ -101,6 +107,7 @@ namespace vvh {
 
 	template<typename T = ComBeginCommandBufferInfo>
 	inline void ComBeginCommandBuffer(T&& info) {
+		VVH_ZONE_FUNCTION;
 
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -124,6 +131,7 @@ namespace vvh {
 
 	template<typename T = ComBeginRenderPassInfo>
 	inline void ComBeginRenderPass(T&& info) {
+		VVH_ZONE_FUNCTION;
 		
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -161,6 +169,7 @@ namespace vvh {
 
 	template<typename T = ComBindPipelineInfo>
 	inline void ComBindPipeline(T&& info) {
+		VVH_ZONE_FUNCTION;
 
 		std::vector<VkViewport> viewPorts = info.m_viewPorts;
 		VkViewport viewport{};
@@ -198,6 +207,7 @@ namespace vvh {
 
 	template<typename T = ComEndCommandBufferInfo>
 	inline void ComEndCommandBuffer(T&& info) {
+		VVH_ZONE_FUNCTION;
 		if (vkEndCommandBuffer(info.m_commandBuffer) != VK_SUCCESS) {
 			throw std::runtime_error("failed to record command buffer!");
 		}
@@ -211,6 +221,7 @@ namespace vvh {
 
 	template<typename T = ComEndRenderPassInfo>
 	inline void ComEndRenderPass(T&& info) {
+        VVH_ZONE_FUNCTION;
         vkCmdEndRenderPass(info.m_commandBuffer);
     }
 
@@ -227,6 +238,7 @@ namespace vvh {
 
 	template<typename T = ComRecordObjectInfo>
 	inline void ComRecordObject(T&& info) {
+		VVH_ZONE_FUNCTION;
 	
 		auto offsets = info.m_mesh.m_verticesData.getOffsets(info.m_type);
 		std::vector<VkBuffer> vertexBuffers(offsets.size(), info.m_mesh.m_vertexBuffer);
@@ -253,10 +265,15 @@ namespace vvh {
         std::vector<Semaphores>& 			m_intermediateSemaphores; 
 		const std::vector<VkFence>& 		m_fences; 
 		const uint32_t& 					m_currentFrame;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		const bool 							m_headless{false}; //no acquired image to wait for, nothing is presented
 	};
 
+	/// @brief Submit the command buffers in order, chained by semaphores. The first one waits for the acquired image,
+	/// the last one signals the frame's fence and the render finished semaphore for presenting.
 	template<typename T = ComSubmitCommandBuffersInfo>
 	inline void ComSubmitCommandBuffers(T&& info) {
+		VVH_ZONE_FUNCTION;
 
 		size_t size = info.m_commandBuffers.size();
 		if( size > info.m_intermediateSemaphores.size() ) {
@@ -265,13 +282,14 @@ namespace vvh {
 				.m_imageAvailableSemaphores = info.m_imageAvailableSemaphores, 
 				.m_renderFinishedSemaphores = info.m_renderFinishedSemaphores, 
 				.m_size 					= size,
-				.m_intermediateSemaphores 	= info.m_intermediateSemaphores 
+				.m_intermediateSemaphores 	= info.m_intermediateSemaphores,
+				.m_pAllocator 				= info.m_pAllocator
 			});
 		}
 
 		vkResetFences(info.m_device, 1, &info.m_fences[info.m_currentFrame]);
 
-		const VkSemaphore* waitSemaphore = &info.m_imageAvailableSemaphores[info.m_currentFrame];
+		const VkSemaphore* waitSemaphore = info.m_headless ? nullptr : &info.m_imageAvailableSemaphores[info.m_currentFrame];
 		std::vector<VkSubmitInfo> submitInfos(info.m_commandBuffers.size());
 		VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
 		VkFence fence = VK_NULL_HANDLE;
@@ -281,16 +299,16 @@ namespace vvh {
 			submitInfos[i].commandBufferCount = 1;
 			submitInfos[i].pCommandBuffers = &info.m_commandBuffers[i];
 			
-			submitInfos[i].waitSemaphoreCount = 1;
+			submitInfos[i].waitSemaphoreCount = waitSemaphore != nullptr ? 1 : 0;
 			submitInfos[i].pWaitSemaphores = waitSemaphore;
 			submitInfos[i].pWaitDstStageMask = waitStages;
 			
 			VkSemaphore* signalSemaphore = &info.m_intermediateSemaphores[i].m_renderFinishedSemaphores[info.m_currentFrame];
 			if( i== size-1 ) {
 				fence = info.m_fences[info.m_currentFrame];
-				signalSemaphore = &info.m_renderFinishedSemaphores[info.m_currentFrame];
+				signalSemaphore = info.m_headless ? nullptr : &info.m_renderFinishedSemaphores[info.m_currentFrame];
 			}
-			submitInfos[i].signalSemaphoreCount = 1;
+			submitInfos[i].signalSemaphoreCount = signalSemaphore != nullptr ? 1 : 0;
 			submitInfos[i].pSignalSemaphores = signalSemaphore;
 
 			waitSemaphore = &info.m_intermediateSemaphores[i].m_renderFinishedSemaphores[info.m_currentFrame];
@@ -311,6 +329,7 @@ namespace vvh {
 
 	template<typename T = ComPresentImageInfo>
 	inline auto ComPresentImage(T&& info) -> VkResult {
+        VVH_ZONE_FUNCTION;
         VkPresentInfoKHR presentInfo{};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
         presentInfo.waitSemaphoreCount = 1;
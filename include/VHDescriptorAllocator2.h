@@ -0,0 +1,229 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <iostream>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Allocates descriptor sets from a chain of pools. Allocation tries the current pool and, if that is out
+	// of memory, moves on to a reset pool or creates a larger one, so it does not fail while the device has
+	// memory. Sets are not freed one by one: Reset() returns all sets at once with vkResetDescriptorPool and
+	// keeps the pools for reuse, so a steady state allocates without creating pools. With a LayoutCache the
+	// allocator counts the descriptors of each type it hands out, and new pools are sized by these counts
+	// instead of the initial ratios. Not thread safe, use one allocator per thread.
+
+	class DescriptorAllocator {
+	public:
+		struct Statistics {
+			uint64_t m_sets{0};			//allocated since Init
+			uint64_t m_pools{0};		//created
+			uint64_t m_exhausted{0};	//pools that ran out of memory
+			uint64_t m_resets{0};
+		};
+
+		/// @brief Relative number of descriptors per set used until usage has been observed.
+		static auto DefaultRatios() -> std::vector<VkDescriptorPoolSize> {
+			return {
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 },
+				{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1 },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 },
+				{ VK_DESCRIPTOR_TYPE_SAMPLER, 1 },
+				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1 },
+			};
+		}
+
+		/// @brief Pools start with setsPerPool sets, each new pool doubles that up to c_maxSetsPerPool.
+		void Init(VkDevice device, LayoutCache* layoutCache = nullptr, uint32_t setsPerPool = 64,
+					std::vector<VkDescriptorPoolSize> ratios = DefaultRatios(), const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_device = device;
+			m_layoutCache = layoutCache;
+			m_setsPerPool = setsPerPool;
+			m_ratios = std::move(ratios);
+			m_pAllocator = pAllocator;
+		}
+
+		void Destroy() {
+			for( auto pool : m_full ) vkDestroyDescriptorPool(m_device, pool, m_pAllocator);
+			for( auto pool : m_ready ) vkDestroyDescriptorPool(m_device, pool, m_pAllocator);
+			if( m_current != VK_NULL_HANDLE ) vkDestroyDescriptorPool(m_device, m_current, m_pAllocator);
+			m_full.clear();
+			m_ready.clear();
+			m_current = VK_NULL_HANDLE;
+			m_layouts.clear();
+		}
+
+		auto Allocate(VkDescriptorSetLayout layout) -> VkDescriptorSet {
+			const Counts& needs = Observe(layout);
+			VkDescriptorSet set = VK_NULL_HANDLE;
+			VkResult result = m_current == VK_NULL_HANDLE ? VK_ERROR_OUT_OF_POOL_MEMORY : TryAllocate(m_current, layout, set);
+			for( uint32_t attempt = 0; attempt < 2 && (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL); ++attempt ) {
+				if( m_current != VK_NULL_HANDLE ) {
+					++m_statistics.m_exhausted;
+					m_full.push_back(m_current);
+				}
+				//a reset pool may have been sized for other layouts, the second attempt gets a new pool that fits
+				m_current = attempt == 0 && !m_ready.empty() ? PopReady() : CreatePool(needs);
+				result = TryAllocate(m_current, layout, set);
+			}
+			if( result != VK_SUCCESS ) {
+				throw std::runtime_error("failed to allocate descriptor set!");
+			}
+			++m_statistics.m_sets;
+			return set;
+		}
+
+		/// @brief Return all sets at once. The caller must make sure the GPU no longer uses them.
+		void Reset() {
+			if( m_current != VK_NULL_HANDLE ) m_full.push_back(m_current);
+			m_current = VK_NULL_HANDLE;
+			for( auto pool : m_full ) {
+				vkResetDescriptorPool(m_device, pool, 0);
+				m_ready.push_back(pool);
+			}
+			m_full.clear();
+			++m_statistics.m_resets;
+		}
+
+		auto GetStatistics() const -> const Statistics& { return m_statistics; }
+
+		/// @brief Pool sizes the next new pool would get.
+		auto PoolSizes() const -> std::vector<VkDescriptorPoolSize> { return PoolSizes(Counts{}); }
+
+		void PrintStatistics(std::ostream& out = std::cout) const {
+			out << "Descriptor allocator: " << m_statistics.m_sets << " sets, " << m_statistics.m_pools << " pools, "
+				<< m_statistics.m_exhausted << " exhausted, " << m_statistics.m_resets << " resets\n";
+		}
+
+	private:
+		static constexpr uint32_t c_maxSetsPerPool = 4096;
+		static constexpr uint32_t c_types = 11;		//core descriptor types, VK_DESCRIPTOR_TYPE_SAMPLER .. INPUT_ATTACHMENT
+		using Counts = std::array<uint32_t, c_types>;
+
+		static auto TypeOf(uint32_t index) -> VkDescriptorType { return (VkDescriptorType)index; }
+
+		/// Sizes from the observed descriptors per set, or the initial ratios, and at least needs.
+		auto PoolSizes(const Counts& needs) const -> std::vector<VkDescriptorPoolSize> {
+			std::vector<VkDescriptorPoolSize> sizes;
+			if( m_observedSets > 0 ) {		//descriptors per set seen so far, rounded up
+				for( uint32_t type = 0; type < c_types; ++type ) {
+					if( m_observed[type] == 0 ) continue;
+					uint64_t count = (m_observed[type] * m_setsPerPool + m_observedSets - 1) / m_observedSets;
+					sizes.push_back({ TypeOf(type), (uint32_t)std::max<uint64_t>(count, 1) });
+				}
+			}
+			if( sizes.empty() ) {
+				for( auto& ratio : m_ratios ) sizes.push_back({ ratio.type, std::max(1u, ratio.descriptorCount * m_setsPerPool) });
+			}
+			for( uint32_t type = 0; type < c_types; ++type ) {
+				if( needs[type] == 0 ) continue;
+				auto it = std::find_if(sizes.begin(), sizes.end(), [&](auto& size) { return size.type == TypeOf(type); });
+				if( it == sizes.end() ) sizes.push_back({ TypeOf(type), needs[type] });
+				else it->descriptorCount = std::max(it->descriptorCount, needs[type]);
+			}
+			return sizes;
+		}
+
+		auto TryAllocate(VkDescriptorPool pool, VkDescriptorSetLayout layout, VkDescriptorSet& set) -> VkResult {
+			VkDescriptorSetAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorPool = pool;
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.pSetLayouts = &layout;
+			return vkAllocateDescriptorSets(m_device, &allocInfo, &set);
+		}
+
+		auto PopReady() -> VkDescriptorPool {
+			VkDescriptorPool pool = m_ready.back();
+			m_ready.pop_back();
+			return pool;
+		}
+
+		/// A new pool, twice as large as the last one.
+		auto CreatePool(const Counts& needs) -> VkDescriptorPool {
+			std::vector<VkDescriptorPoolSize> sizes = PoolSizes(needs);
+			VkDescriptorPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			poolInfo.maxSets = m_setsPerPool;
+			poolInfo.poolSizeCount = (uint32_t)sizes.size();
+			poolInfo.pPoolSizes = sizes.data();
+
+			VkDescriptorPool pool;
+			if (vkCreateDescriptorPool(m_device, &poolInfo, m_pAllocator, &pool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create descriptor pool!");
+			}
+			++m_statistics.m_pools;
+			m_setsPerPool = std::min(m_setsPerPool * 2, c_maxSetsPerPool);
+			return pool;
+		}
+
+		/// Count the descriptors of the set and return its needs, the bindings of each layout are looked up once.
+		auto Observe(VkDescriptorSetLayout layout) -> const Counts& {
+			static const Counts unknown{};
+			if( m_layoutCache == nullptr ) return unknown;
+			auto [it, inserted] = m_layouts.try_emplace(layout, Counts{});
+			if( inserted ) {
+				for( auto& binding : m_layoutCache->Bindings(layout) ) {
+					if( (uint32_t)binding.descriptorType < c_types ) it->second[binding.descriptorType] += binding.descriptorCount;
+				}
+			}
+			for( uint32_t type = 0; type < c_types; ++type ) m_observed[type] += it->second[type];
+			++m_observedSets;
+			return it->second;
+		}
+
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		LayoutCache* 			m_layoutCache{nullptr};
+		uint32_t 				m_setsPerPool{64};
+		std::vector<VkDescriptorPoolSize> m_ratios;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		VkDescriptorPool 		m_current{VK_NULL_HANDLE};
+		std::vector<VkDescriptorPool> m_full;		//used since the last reset
+		std::vector<VkDescriptorPool> m_ready;		//reset, waiting for reuse
+		std::unordered_map<VkDescriptorSetLayout, Counts> m_layouts;
+		std::array<uint64_t, c_types> m_observed{};
+		uint64_t 				m_observedSets{0};
+		Statistics 				m_statistics;
+	};
+
+
+	//---------------------------------------------------------------------------------------------
+	// Descriptor sets that live for one frame. There is an allocator per frame in flight, BeginFrame() resets
+	// the one of the frame about to be recorded, after its fence was waited for.
+
+	class FrameDescriptors {
+	public:
+		void Init(VkDevice device, LayoutCache* layoutCache = nullptr, uint32_t framesInFlight = MAX_FRAMES_IN_FLIGHT,
+					uint32_t setsPerPool = 64, const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_frames.resize(framesInFlight);
+			for( auto& frame : m_frames ) frame.Init(device, layoutCache, setsPerPool, DescriptorAllocator::DefaultRatios(), pAllocator);
+		}
+
+		void Destroy() {
+			for( auto& frame : m_frames ) frame.Destroy();
+			m_frames.clear();
+		}
+
+		void BeginFrame(uint32_t currentFrame) {
+			m_currentFrame = currentFrame;
+			m_frames[m_currentFrame].Reset();
+		}
+
+		auto Allocate(VkDescriptorSetLayout layout) -> VkDescriptorSet { return m_frames[m_currentFrame].Allocate(layout); }
+
+		auto Frame(uint32_t frame) -> DescriptorAllocator& { return m_frames[frame]; }
+
+	private:
+		std::vector<DescriptorAllocator> m_frames;
+		uint32_t 	m_currentFrame{0};
+	};
+
+} // namespace vvh
+
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <iostream>
+
+
+namespace vvh {
+
+	enum class DescriptorBackend { Pool, Buffer };
+
+	//---------------------------------------------------------------------------------------------
+	// Descriptors in a host visible buffer, with VK_EXT_descriptor_buffer, as an alternative to pools and
+	// sets. A set is an offset into the buffer: Write() gets each descriptor of a DescriptorSetKey with
+	// vkGetDescriptorEXT and copies it to the offsets the layout gives, so updating is a memcpy and nothing
+	// is allocated or freed. Bind() binds the buffer once and sets the offsets of the sets.
+	// The buffer has a persistent part, filled by Allocate() until Destroy(), and a part for each frame in
+	// flight, filled by AllocateFrame() and rewound by BeginFrame(). Set layouts must be created with
+	// m_descriptorBuffer, pipelines using them with VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT, and
+	// buffers referenced by descriptors with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT. Buffer descriptors
+	// need an explicit range. Texel buffers and dynamic buffers are not supported. Not thread safe.
+
+	class DescriptorBuffer {
+	public:
+		struct Statistics {
+			uint64_t m_sets{0};			//allocated since Init
+			uint64_t m_descriptors{0};	//written since Init
+			uint64_t m_frameBytes{0};	//most bytes used by one frame
+		};
+
+		/// @brief True if the device can use this backend. Needs Vulkan 1.3, which has all its dependencies.
+		static auto Supported(VkPhysicalDevice physicalDevice, uint32_t apiVersion) -> bool {
+			if( VK_VERSION_MINOR(apiVersion) < 3 ) return false;
+			std::vector<std::string> extensions{ VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME };
+			if( !DevCheckDeviceExtensionSupport({ physicalDevice, extensions }) ) return false;
+			VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBuffer{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT };
+			VkPhysicalDeviceFeatures2 features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &descriptorBuffer };
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+			return descriptorBuffer.descriptorBuffer == VK_TRUE;
+		}
+
+		/// @brief The VMA allocator must have been created with m_bufferDeviceAddress. The sizes are shrunk in proportion if
+		/// they exceed maxSamplerDescriptorBufferRange or maxResourceDescriptorBufferRange.
+		void Init(VkPhysicalDevice physicalDevice, VkDevice device, VmaAllocator vmaAllocator, VkDeviceSize persistentSize = 1 << 20,
+					VkDeviceSize frameSize = 1 << 20, uint32_t framesInFlight = MAX_FRAMES_IN_FLIGHT) {
+			m_device = device;
+			m_vmaAllocator = vmaAllocator;
+			m_properties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT };
+			VkPhysicalDeviceProperties2 properties{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &m_properties };
+			vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+			m_persistentSize = Align(persistentSize);
+			m_frameSize = Align(frameSize);
+			//the buffer is bound for samplers and resources, so it must fit the smaller of both ranges
+			VkDeviceSize limit = std::min(m_properties.maxSamplerDescriptorBufferRange, m_properties.maxResourceDescriptorBufferRange);
+			VkDeviceSize total = m_persistentSize + m_frameSize * framesInFlight;
+			if( total > limit ) {	//shrink all parts by the same factor
+				double scale = (double)limit / total;
+				m_persistentSize = AlignDown((VkDeviceSize)(m_persistentSize * scale));
+				m_frameSize = AlignDown((VkDeviceSize)(m_frameSize * scale));
+				if( m_frameSize == 0 || (persistentSize > 0 && m_persistentSize == 0) ) {	//a part that was asked for must not vanish
+					throw std::runtime_error("failed to create descriptor buffer, the device's descriptor buffer range is too small!");
+				}
+			}
+			m_frames.assign(framesInFlight, 0);
+			m_usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT
+				| VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+			VmaAllocationInfo allocInfo;
+			BufCreateBuffer( {
+				.m_vmaAllocator = m_vmaAllocator,
+				.m_size 		= m_persistentSize + m_frameSize * framesInFlight,
+				.m_usageFlags 	= m_usage,
+				.m_properties 	= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				.m_vmaFlags 	= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+				.m_buffer 		= m_buffer,
+				.m_allocation 	= m_allocation,
+				.m_allocationInfo = &allocInfo
+			});
+			if( m_buffer == VK_NULL_HANDLE || allocInfo.pMappedData == nullptr ) {
+				throw std::runtime_error("failed to create descriptor buffer!");
+			}
+			m_mapped = (char*)allocInfo.pMappedData;
+			VkBufferDeviceAddressInfo addressInfo{ VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO, nullptr, m_buffer };
+			m_address = vkGetBufferDeviceAddress(m_device, &addressInfo);
+		}
+
+		void Destroy() {
+			if( m_buffer != VK_NULL_HANDLE ) vmaDestroyBuffer(m_vmaAllocator, m_buffer, m_allocation);
+			m_buffer = VK_NULL_HANDLE;
+			m_mapped = nullptr;
+			m_persistent = 0;
+			m_layouts.clear();
+		}
+
+		/// @brief Call once per frame, after waiting for the fence of the frame about to be recorded.
+		void BeginFrame(uint32_t currentFrame) {
+			m_currentFrame = currentFrame;
+			m_frames[m_currentFrame] = 0;
+		}
+
+		/// @brief Space for a set that lives until Destroy().
+		auto Allocate(VkDescriptorSetLayout layout) -> VkDeviceSize {
+			return Bump(m_persistent, m_persistentSize, 0, layout, "failed to allocate persistent descriptors, the descriptor buffer is full!");
+		}
+
+		/// @brief Space for a set that lives for the current frame.
+		auto AllocateFrame(VkDescriptorSetLayout layout) -> VkDeviceSize {
+			VkDeviceSize offset = Bump(m_frames[m_currentFrame], m_frameSize, m_persistentSize + m_frameSize * m_currentFrame, layout,
+				"failed to allocate frame descriptors, the descriptor buffer is full!");
+			m_statistics.m_frameBytes = std::max<uint64_t>(m_statistics.m_frameBytes, m_frames[m_currentFrame]);
+			return offset;
+		}
+
+		/// @brief Write the descriptors of key into the set at offset.
+		void Write(VkDeviceSize offset, VkDescriptorSetLayout layout, const DescriptorSetKey& key) {
+			Layout& info = GetLayout(layout);
+			for( auto& e : key.Entries() ) {
+				auto type = (VkDescriptorType)e.m_type;
+				VkDescriptorImageInfo image{ (VkSampler)e.m_sampler, (VkImageView)e.m_resource, (VkImageLayout)e.m_imageLayout };
+				VkSampler sampler = (VkSampler)e.m_sampler;
+				VkDescriptorAddressInfoEXT address{ VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT };
+				VkDescriptorGetInfoEXT getInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT };
+				getInfo.type = type;
+				size_t size = 0;
+				switch( type ) {
+					case VK_DESCRIPTOR_TYPE_SAMPLER:
+						getInfo.data.pSampler = &sampler; size = m_properties.samplerDescriptorSize; break;
+					case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+						if( e.m_arrayElement > 0 && !m_properties.combinedImageSamplerDescriptorSingleArray ) {
+							throw std::runtime_error("failed to write descriptor, arrays of combined image samplers are split on this device!");
+						}
+						getInfo.data.pCombinedImageSampler = &image; size = m_properties.combinedImageSamplerDescriptorSize; break;
+					case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+						getInfo.data.pSampledImage = &image; size = m_properties.sampledImageDescriptorSize; break;
+					case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+						getInfo.data.pStorageImage = &image; size = m_properties.storageImageDescriptorSize; break;
+					case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+						getInfo.data.pInputAttachmentImage = &image; size = m_properties.inputAttachmentDescriptorSize; break;
+					case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+					case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: {
+						if( e.m_range == VK_WHOLE_SIZE ) throw std::runtime_error("failed to write descriptor, buffers need an explicit range!");
+						VkBufferDeviceAddressInfo addressInfo{ VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO, nullptr, (VkBuffer)e.m_resource };
+						address.address = vkGetBufferDeviceAddress(m_device, &addressInfo) + e.m_offset;
+						address.range = e.m_range;
+						bool uniform = type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+						if( uniform ) getInfo.data.pUniformBuffer = &address; else getInfo.data.pStorageBuffer = &address;
+						size = uniform ? m_properties.uniformBufferDescriptorSize : m_properties.storageBufferDescriptorSize;
+						break;
+					}
+					default:
+						throw std::runtime_error("failed to write descriptor, the type is not supported by the descriptor buffer backend!");
+				}
+				VkDeviceSize bindingOffset = BindingOffset(layout, info, e.m_binding);
+				vkGetDescriptorEXT(m_device, &getInfo, size, m_mapped + offset + bindingOffset + e.m_arrayElement * size);
+				++m_statistics.m_descriptors;
+			}
+		}
+
+		/// @brief Bind the buffer and point the sets firstSet, firstSet + 1, ... to offsets.
+		void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t firstSet,
+					const std::vector<VkDeviceSize>& offsets) {
+			VkDescriptorBufferBindingInfoEXT bindingInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT };
+			bindingInfo.address = m_address;
+			bindingInfo.usage = m_usage;
+			vkCmdBindDescriptorBuffersEXT(commandBuffer, 1, &bindingInfo);
+			std::vector<uint32_t> indices(offsets.size(), 0);
+			vkCmdSetDescriptorBufferOffsetsEXT(commandBuffer, bindPoint, pipelineLayout, firstSet, (uint32_t)offsets.size(), indices.data(), offsets.data());
+		}
+
+		auto Handle() const -> VkBuffer { return m_buffer; }
+		auto Address() const -> VkDeviceAddress { return m_address; }
+		auto GetStatistics() const -> const Statistics& { return m_statistics; }
+
+		void PrintStatistics(std::ostream& out = std::cout) const {
+			out << "Descriptor buffer: " << m_statistics.m_sets << " sets, " << m_statistics.m_descriptors << " descriptors, "
+				<< m_persistent << " persistent bytes, " << m_statistics.m_frameBytes << " bytes per frame at most\n";
+		}
+
+	private:
+		struct Layout {
+			VkDeviceSize 	m_size{0};
+			std::unordered_map<uint32_t, VkDeviceSize> m_bindingOffsets;
+		};
+
+		auto Align(VkDeviceSize size) const -> VkDeviceSize {
+			VkDeviceSize alignment = std::max<VkDeviceSize>(m_properties.descriptorBufferOffsetAlignment, 1);
+			return (size + alignment - 1) / alignment * alignment;
+		}
+
+		auto AlignDown(VkDeviceSize size) const -> VkDeviceSize {
+			VkDeviceSize alignment = std::max<VkDeviceSize>(m_properties.descriptorBufferOffsetAlignment, 1);
+			return size / alignment * alignment;
+		}
+
+		/// Sizes and binding offsets are asked once per layout.
+		auto GetLayout(VkDescriptorSetLayout layout) -> Layout& {
+			auto [it, inserted] = m_layouts.try_emplace(layout);
+			if( inserted ) vkGetDescriptorSetLayoutSizeEXT(m_device, layout, &it->second.m_size);
+			return it->second;
+		}
+
+		auto BindingOffset(VkDescriptorSetLayout layout, Layout& info, uint32_t binding) -> VkDeviceSize {
+			auto [it, inserted] = info.m_bindingOffsets.try_emplace(binding, 0);
+			if( inserted ) vkGetDescriptorSetLayoutBindingOffsetEXT(m_device, layout, binding, &it->second);
+			return it->second;
+		}
+
+		auto Bump(VkDeviceSize& used, VkDeviceSize capacity, VkDeviceSize base, VkDescriptorSetLayout layout, const char* error) -> VkDeviceSize {
+			VkDeviceSize size = Align(GetLayout(layout).m_size);
+			if( used + size > capacity ) throw std::runtime_error(error);
+			VkDeviceSize offset = base + used;
+			used += size;
+			++m_statistics.m_sets;
+			return offset;
+		}
+
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		VmaAllocator 			m_vmaAllocator{VK_NULL_HANDLE};
+		VkPhysicalDeviceDescriptorBufferPropertiesEXT m_properties{};
+		VkBuffer 				m_buffer{VK_NULL_HANDLE};
+		VmaAllocation 			m_allocation{VK_NULL_HANDLE};
+		VkBufferUsageFlags 		m_usage{0};
+		char* 					m_mapped{nullptr};
+		VkDeviceAddress 		m_address{0};
+		VkDeviceSize 			m_persistentSize{0};
+		VkDeviceSize 			m_frameSize{0};
+		VkDeviceSize 			m_persistent{0};		//bytes used
+		std::vector<VkDeviceSize> m_frames;				//bytes used by each frame in flight
+		uint32_t 				m_currentFrame{0};
+		std::unordered_map<VkDescriptorSetLayout, Layout> m_layouts;
+		Statistics 				m_statistics;
+	};
+
+} // namespace vvh
+
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <iostream>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Reuses descriptor sets with equal contents. A DescriptorSetKey lists what is bound to each binding, the
+	// cache maps (layout, key) to a set and writes a new set with a DescriptorWriter only the first time a
+	// combination is seen. Objects sharing a material get the same set. Sets not used for a while are evicted
+	// in least recently used order once there are more than the capacity, but only if no frame in flight can
+	// still use them. Evicted sets are rewritten for later misses with the same layout instead of being freed.
+	// Not thread safe.
+
+	class DescriptorSetCache {
+	public:
+		struct Statistics {
+			uint64_t m_hits{0};
+			uint64_t m_misses{0};		//each miss wrote a set
+			uint64_t m_evictions{0};
+			uint64_t m_recycled{0};		//misses that rewrote an evicted set
+		};
+
+		/// @brief Without a writer, sets are written by an internal one that does not use templates.
+		void Init(VkDevice device, DescriptorAllocator& allocator, uint32_t capacity = 4096, uint32_t framesInFlight = MAX_FRAMES_IN_FLIGHT,
+					DescriptorWriter* writer = nullptr) {
+			m_device = device;
+			m_allocator = &allocator;
+			m_ownWriter.Init(device);
+			m_writer = writer != nullptr ? writer : &m_ownWriter;
+			m_capacity = capacity;
+			m_framesInFlight = framesInFlight;
+		}
+
+		/// @brief The sets belong to the allocator, they are returned when it is reset or destroyed.
+		void Destroy() {
+			m_ownWriter.Destroy();
+			m_lookup.clear();
+			m_lru.clear();
+			m_free.clear();
+		}
+
+		/// @brief Call once per frame, after waiting for the fence of the frame about to be recorded.
+		void BeginFrame(uint64_t frameNumber) {
+			m_frame = frameNumber;
+			while( !m_lru.empty() ) {
+				Node& node = m_lru.back();
+				bool inFlight = node.m_lastFrame + m_framesInFlight > m_frame;
+				if( inFlight || (!node.m_dead && m_lru.size() <= m_capacity) ) break;
+				if( !node.m_dead ) Unlink(std::prev(m_lru.end()));
+				m_free[node.m_layout].push_back(node.m_set);
+				++m_statistics.m_evictions;
+				m_lru.pop_back();
+			}
+		}
+
+		/// @brief The set with these contents, written on the first request.
+		auto Get(VkDescriptorSetLayout layout, const DescriptorSetKey& key) -> VkDescriptorSet {
+			uint64_t hash = key.Hash(layout);
+			auto [first, last] = m_lookup.equal_range(hash);
+			for( auto it = first; it != last; ++it ) {
+				Node& node = *it->second;
+				if( node.m_layout == layout && node.m_entries == key.Entries() ) {
+					++m_statistics.m_hits;
+					node.m_lastFrame = m_frame;
+					m_lru.splice(m_lru.begin(), m_lru, it->second);
+					return node.m_set;
+				}
+			}
+
+			++m_statistics.m_misses;
+			VkDescriptorSet set;
+			auto& free = m_free[layout];
+			if( !free.empty() ) {
+				set = free.back();
+				free.pop_back();
+				++m_statistics.m_recycled;
+			} else set = m_allocator->Allocate(layout);
+			m_writer->Write(set, layout, key);
+			m_lru.push_front({ layout, key.Entries(), set, hash, m_frame, false });
+			m_lookup.emplace(hash, m_lru.begin());
+			return set;
+		}
+
+		/// @brief Stop handing out sets that reference resource, e.g. before destroying an image view or buffer.
+		/// The sets are recycled once no frame in flight uses them.
+		void Evict(uint64_t resource) {
+			for( auto it = m_lru.begin(); it != m_lru.end(); ) {
+				auto next = std::next(it);
+				bool uses = std::any_of(it->m_entries.begin(), it->m_entries.end(),
+					[&](auto& e) { return e.m_resource == resource || e.m_sampler == resource; });
+				if( uses && !it->m_dead ) {
+					Unlink(it);
+					it->m_dead = true;
+					m_lru.splice(m_lru.end(), m_lru, it);	//dead nodes wait at the back
+				}
+				it = next;
+			}
+		}
+
+		auto GetStatistics() const -> const Statistics& { return m_statistics; }
+		auto Size() const -> size_t { return m_lookup.size(); }
+
+		void PrintStatistics(std::ostream& out = std::cout) const {
+			out << "Descriptor set cache: " << m_lookup.size() << " sets, " << m_statistics.m_hits << " hits, " << m_statistics.m_misses
+				<< " misses, " << m_statistics.m_evictions << " evictions, " << m_statistics.m_recycled << " recycled\n";
+		}
+
+	private:
+		struct Node {
+			VkDescriptorSetLayout 	m_layout;
+			std::vector<DescriptorSetKey::Entry> m_entries;
+			VkDescriptorSet 		m_set;
+			uint64_t 				m_hash;
+			uint64_t 				m_lastFrame;
+			bool 					m_dead;		//evicted from the lookup, waiting for the frames in flight
+		};
+		using Iterator = std::list<Node>::iterator;
+
+		void Unlink(Iterator node) {
+			auto [first, last] = m_lookup.equal_range(node->m_hash);
+			for( auto it = first; it != last; ++it ) {
+				if( it->second == node ) { m_lookup.erase(it); return; }
+			}
+		}
+
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		DescriptorAllocator* 	m_allocator{nullptr};
+		DescriptorWriter* 		m_writer{nullptr};
+		DescriptorWriter 		m_ownWriter;
+		uint32_t 				m_capacity{4096};
+		uint32_t 				m_framesInFlight{MAX_FRAMES_IN_FLIGHT};
+		uint64_t 				m_frame{0};
+		std::list<Node> 		m_lru;			//most recently used first
+		std::unordered_multimap<uint64_t, Iterator> m_lookup;
+		std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> m_free;
+		Statistics 				m_statistics;
+	};
+
+} // namespace vvh
+
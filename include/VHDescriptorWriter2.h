@@ -0,0 +1,334 @@
+#pragma once
+
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <iostream>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// The contents of a descriptor set: what is bound to each binding and array element. Entries are kept
+	// sorted, so keys built in a different order compare and hash equal.
+
+	class DescriptorSetKey {
+	public:
+		struct Entry {
+			uint32_t 	m_binding{0};
+			uint32_t 	m_arrayElement{0};
+			uint64_t 	m_resource{0};		//VkBuffer, VkImageView or VkBufferView
+			uint64_t 	m_sampler{0};
+			uint64_t 	m_offset{0};
+			uint64_t 	m_range{0};
+			uint32_t 	m_type{0};			//VkDescriptorType
+			uint32_t 	m_imageLayout{0};
+
+			bool operator==(const Entry&) const = default;
+		};
+
+		auto Buffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE,
+					uint32_t arrayElement = 0) -> DescriptorSetKey& {
+			return Add({ binding, arrayElement, (uint64_t)buffer, 0, offset, range, (uint32_t)type, 0 });
+		}
+
+		auto Image(uint32_t binding, VkDescriptorType type, VkImageView view, VkSampler sampler = VK_NULL_HANDLE,
+					VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, uint32_t arrayElement = 0) -> DescriptorSetKey& {
+			return Add({ binding, arrayElement, (uint64_t)view, (uint64_t)sampler, 0, 0, (uint32_t)type, (uint32_t)layout });
+		}
+
+		auto Texture(uint32_t binding, const vvh::Image& texture, uint32_t arrayElement = 0) -> DescriptorSetKey& {
+			return Image(binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, texture.m_mapImageView, texture.m_mapSampler,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, arrayElement);
+		}
+
+		auto TexelBuffer(uint32_t binding, VkDescriptorType type, VkBufferView view, uint32_t arrayElement = 0) -> DescriptorSetKey& {
+			return Add({ binding, arrayElement, (uint64_t)view, 0, 0, 0, (uint32_t)type, 0 });
+		}
+
+		auto Entries() const -> const std::vector<Entry>& { return m_entries; }
+
+		auto Hash(VkDescriptorSetLayout layout) const -> uint64_t {
+			uint64_t hash = 14695981039346656037ull;	//FNV-1a over 64 bit words
+			auto mix = [&](uint64_t value) { hash ^= value; hash *= 1099511628211ull; };
+			mix((uint64_t)layout);
+			for( auto& e : m_entries ) {
+				mix((uint64_t)e.m_binding << 32 | e.m_arrayElement); mix(e.m_resource); mix(e.m_sampler);
+				mix(e.m_offset); mix(e.m_range); mix((uint64_t)e.m_type << 32 | e.m_imageLayout);
+			}
+			return hash;
+		}
+
+	private:
+		/// Keep the entries sorted, so the order of the calls does not matter. Binding again replaces.
+		auto Add(const Entry& entry) -> DescriptorSetKey& {
+			auto it = std::lower_bound(m_entries.begin(), m_entries.end(), entry,
+				[](auto& a, auto& b) { return std::tie(a.m_binding, a.m_arrayElement) < std::tie(b.m_binding, b.m_arrayElement); });
+			if( it != m_entries.end() && it->m_binding == entry.m_binding && it->m_arrayElement == entry.m_arrayElement ) *it = entry;
+			else m_entries.insert(it, entry);
+			return *this;
+		}
+
+		std::vector<Entry> m_entries;
+	};
+
+
+	//---------------------------------------------------------------------------------------------
+	// Writes descriptor sets in batches. Queue() only records the writes, Flush() hands them to the driver in
+	// queue order, with one vkUpdateDescriptorSets call per run of plain writes. The write structs and the buffer and image infos they point
+	// to live in scratch vectors that keep their memory between flushes, so a steady state does not allocate.
+	// With a LayoutCache, a key that covers every descriptor of its layout is written with one
+	// vkUpdateDescriptorSetWithTemplate call instead, with an update template made from the layout's bindings
+	// on first use. Layouts the cache does not know, or that have types a template cannot hold, fall back to
+	// plain writes. Not thread safe, use one writer per thread.
+
+	class DescriptorWriter {
+	public:
+		struct Statistics {
+			uint64_t m_descriptors{0};		//written since Init
+			uint64_t m_calls{0};			//vkUpdateDescriptorSets and vkUpdateDescriptorSetWithTemplate calls
+			uint64_t m_templateWrites{0};	//sets written with a template
+			uint64_t m_templates{0};		//created
+		};
+
+		void Init(VkDevice device, LayoutCache* layoutCache = nullptr, bool useTemplates = true, const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_device = device;
+			m_layoutCache = layoutCache;
+			m_useTemplates = useTemplates && layoutCache != nullptr;
+			m_pAllocator = pAllocator;
+		}
+
+		/// @brief Drops writes that were not flushed.
+		void Destroy() {
+			for( auto& [layout, t] : m_templates ) {
+				if( t.m_template != VK_NULL_HANDLE ) vkDestroyDescriptorUpdateTemplate(m_device, t.m_template, m_pAllocator);
+			}
+			m_templates.clear();
+			Clear();
+		}
+
+		/// @brief Record the writes of key to set. Nothing reaches the driver before Flush().
+		void Queue(VkDescriptorSet set, VkDescriptorSetLayout layout, const DescriptorSetKey& key) {
+			auto& entries = key.Entries();
+			m_statistics.m_descriptors += entries.size();
+			if( const Template* t = FindTemplate(layout, key) ) {
+				size_t first = m_slots.size();
+				m_slots.resize(first + t->m_slots);
+				for( auto& e : entries ) m_slots[first + t->m_bindings.at(e.m_binding).m_base + e.m_arrayElement] = MakeSlot(e);
+				m_templateWrites.push_back({ set, t->m_template, first, m_writes.size() });
+				return;
+			}
+			for( auto& e : entries ) {
+				VkWriteDescriptorSet write{};
+				write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				write.dstSet = set;
+				write.dstBinding = e.m_binding;
+				write.dstArrayElement = e.m_arrayElement;
+				write.descriptorType = (VkDescriptorType)e.m_type;
+				write.descriptorCount = 1;
+				m_writes.push_back(write);
+				m_writeSlots.push_back(m_slots.size());	//the slots may still move, pointers are set in Flush()
+				m_slots.push_back(MakeSlot(e));
+			}
+		}
+
+		/// @brief Hand all queued writes to the driver in the order they were queued, so if a set was queued more
+		/// than once, the last key wins. Plain writes between two template writes go in one call.
+		void Flush() {
+			VVH_ZONE("DescriptorWriter::Flush");
+			for( size_t i = 0; i < m_writes.size(); ++i ) {
+				PointTo(m_writes[i], m_slots[m_writeSlots[i]]);
+			}
+			size_t written = 0;
+			auto writeUpTo = [&](size_t end) {
+				if( end == written ) return;
+				vkUpdateDescriptorSets(m_device, (uint32_t)(end - written), m_writes.data() + written, 0, nullptr);
+				++m_statistics.m_calls;
+				written = end;
+			};
+			for( auto& w : m_templateWrites ) {
+				writeUpTo(w.m_writesBefore);
+				vkUpdateDescriptorSetWithTemplate(m_device, w.m_set, w.m_template, &m_slots[w.m_firstSlot]);
+				++m_statistics.m_calls;
+				++m_statistics.m_templateWrites;
+			}
+			writeUpTo(m_writes.size());
+			Clear();
+		}
+
+		/// @brief Queue and flush one set.
+		void Write(VkDescriptorSet set, VkDescriptorSetLayout layout, const DescriptorSetKey& key) {
+			Queue(set, layout, key);
+			Flush();
+		}
+
+		auto Pending() const -> size_t { return m_writes.size() + m_templateWrites.size(); }
+		auto GetStatistics() const -> const Statistics& { return m_statistics; }
+
+		void PrintStatistics(std::ostream& out = std::cout) const {
+			out << "Descriptor writer: " << m_statistics.m_descriptors << " descriptors, " << m_statistics.m_calls << " calls, "
+				<< m_statistics.m_templateWrites << " template writes, " << m_statistics.m_templates << " templates\n";
+		}
+
+		/// One descriptor, laid out as the template and the write structs expect it. Also used by ComPushDescriptors.
+		union Slot {
+			VkDescriptorImageInfo 	m_image;
+			VkDescriptorBufferInfo 	m_buffer;
+			VkBufferView 			m_view;
+		};
+
+		enum class SlotKind { Image, Buffer, TexelBuffer, Unsupported };
+
+		static auto Kind(VkDescriptorType type) -> SlotKind {
+			switch( type ) {
+				case VK_DESCRIPTOR_TYPE_SAMPLER:
+				case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+				case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+				case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+				case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: return SlotKind::Image;
+				case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+				case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER: return SlotKind::TexelBuffer;
+				case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+				case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+				case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+				case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: return SlotKind::Buffer;
+				default: return SlotKind::Unsupported;		//inline uniform blocks, acceleration structures
+			}
+		}
+
+		static auto MakeSlot(const DescriptorSetKey::Entry& e) -> Slot {
+			Slot slot{};
+			switch( Kind((VkDescriptorType)e.m_type) ) {
+				case SlotKind::TexelBuffer: slot.m_view = (VkBufferView)e.m_resource; break;
+				case SlotKind::Buffer: slot.m_buffer = { (VkBuffer)e.m_resource, e.m_offset, e.m_range }; break;
+				default: slot.m_image = { (VkSampler)e.m_sampler, (VkImageView)e.m_resource, (VkImageLayout)e.m_imageLayout }; break;
+			}
+			return slot;
+		}
+
+		/// Let the write read its descriptor from slot, the pointer member depends on the type.
+		static void PointTo(VkWriteDescriptorSet& write, Slot& slot) {
+			switch( Kind(write.descriptorType) ) {
+				case SlotKind::TexelBuffer: write.pTexelBufferView = &slot.m_view; break;
+				case SlotKind::Buffer: write.pBufferInfo = &slot.m_buffer; break;
+				default: write.pImageInfo = &slot.m_image; break;
+			}
+		}
+
+	private:
+		struct Template {
+			struct Binding {
+				uint32_t 	m_base;		//first slot
+				uint32_t 	m_count;
+				uint32_t 	m_type;
+			};
+			VkDescriptorUpdateTemplate 	m_template{VK_NULL_HANDLE};		//null if the layout is written without one
+			std::unordered_map<uint32_t, Binding> m_bindings;
+			size_t 						m_slots{0};					//descriptors in the layout
+		};
+
+		struct TemplateWrite {
+			VkDescriptorSet 			m_set;
+			VkDescriptorUpdateTemplate 	m_template;
+			size_t 						m_firstSlot;
+			size_t 						m_writesBefore;		//plain writes queued before this one
+		};
+
+		/// The template of the layout if key writes all of its descriptors with the right types, else null.
+		auto FindTemplate(VkDescriptorSetLayout layout, const DescriptorSetKey& key) -> const Template* {
+			if( !m_useTemplates ) return nullptr;
+			auto [it, inserted] = m_templates.try_emplace(layout);
+			if( inserted ) CreateTemplate(layout, it->second);
+			const Template& t = it->second;
+			if( t.m_template == VK_NULL_HANDLE || key.Entries().size() != t.m_slots ) return nullptr;
+			for( auto& e : key.Entries() ) {	//entries are unique, so in range and as many as slots means all are covered
+				auto binding = t.m_bindings.find(e.m_binding);
+				if( binding == t.m_bindings.end() || e.m_arrayElement >= binding->second.m_count || e.m_type != binding->second.m_type ) return nullptr;
+			}
+			return &t;
+		}
+
+		void CreateTemplate(VkDescriptorSetLayout layout, Template& t) {
+			auto bindings = m_layoutCache->Bindings(layout);
+			std::sort(bindings.begin(), bindings.end(), [](auto& a, auto& b) { return a.binding < b.binding; });
+			std::vector<VkDescriptorUpdateTemplateEntry> entries;
+			for( auto& binding : bindings ) {
+				if( binding.descriptorCount == 0 ) continue;
+				if( Kind(binding.descriptorType) == SlotKind::Unsupported ) return;
+				entries.push_back({ binding.binding, 0, binding.descriptorCount, binding.descriptorType, t.m_slots * sizeof(Slot), sizeof(Slot) });
+				t.m_bindings[binding.binding] = { (uint32_t)t.m_slots, binding.descriptorCount, (uint32_t)binding.descriptorType };
+				t.m_slots += binding.descriptorCount;
+			}
+			if( entries.empty() ) return;
+
+			VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+			templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+			templateInfo.descriptorUpdateEntryCount = (uint32_t)entries.size();
+			templateInfo.pDescriptorUpdateEntries = entries.data();
+			templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+			templateInfo.descriptorSetLayout = layout;
+			if( vkCreateDescriptorUpdateTemplate(m_device, &templateInfo, m_pAllocator, &t.m_template) != VK_SUCCESS ) {
+				t.m_template = VK_NULL_HANDLE;	//plain writes still work
+				return;
+			}
+			++m_statistics.m_templates;
+		}
+
+		void Clear() {
+			m_writes.clear();
+			m_writeSlots.clear();
+			m_templateWrites.clear();
+			m_slots.clear();
+		}
+
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		LayoutCache* 			m_layoutCache{nullptr};
+		bool 					m_useTemplates{true};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		std::vector<VkWriteDescriptorSet> m_writes;		//scratch, cleared but not freed by Flush()
+		std::vector<size_t> 	m_writeSlots;			//slot of each write
+		std::vector<TemplateWrite> m_templateWrites;
+		std::vector<Slot> 		m_slots;
+		std::unordered_map<VkDescriptorSetLayout, Template> m_templates;
+		Statistics 				m_statistics;
+	};
+
+	//---------------------------------------------------------------------------------------------
+	// Writes the bindings of key straight into the command buffer with VK_KHR_push_descriptor, instead of
+	// allocating, writing and binding a set. The set must have been created with m_pushDescriptor. Needs the
+	// extension to be enabled. The descriptors are copied, so nothing needs to outlive the call.
+
+	struct ComPushDescriptorsInfo {
+		const VkCommandBuffer& 		m_commandBuffer;
+		const VkPipelineLayout& 	m_pipelineLayout;
+		const uint32_t 				m_set;
+		const DescriptorSetKey& 	m_descriptors;
+		const VkPipelineBindPoint 	m_bindPoint{VK_PIPELINE_BIND_POINT_GRAPHICS};
+	};
+
+	template<typename T = ComPushDescriptorsInfo>
+	inline void ComPushDescriptors(T&& info) {
+		VVH_ZONE_FUNCTION;
+
+		//scratch per thread keeps its memory, so pushing per draw does not allocate. Sized first so the pointers stay valid
+		thread_local std::vector<DescriptorWriter::Slot> slots;
+		thread_local std::vector<VkWriteDescriptorSet> writes;
+		auto& entries = info.m_descriptors.Entries();
+		slots.resize(entries.size());
+		writes.assign(entries.size(), VkWriteDescriptorSet{});
+		for( size_t i = 0; i < entries.size(); ++i ) {
+			auto& e = entries[i];
+			slots[i] = DescriptorWriter::MakeSlot(e);
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstBinding = e.m_binding;
+			writes[i].dstArrayElement = e.m_arrayElement;
+			writes[i].descriptorType = (VkDescriptorType)e.m_type;
+			writes[i].descriptorCount = 1;
+			DescriptorWriter::PointTo(writes[i], slots[i]);
+		}
+		vkCmdPushDescriptorSetKHR(info.m_commandBuffer, info.m_bindPoint, info.m_pipelineLayout, info.m_set, (uint32_t)writes.size(), writes.data());
+	}
+
+} // namespace vvh
+
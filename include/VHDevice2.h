@@ -43,7 +43,7 @@ namespace vvh {
 	inline VkResult DevCreateDebugUtilsMessengerEXT(
 			VkInstance 							instance,
 			VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
-			VkAllocationCallbacks* 				pAllocator,
+			const VkAllocationCallbacks* 		pAllocator,
 			VkDebugUtilsMessengerEXT* 			pDebugMessenger) {
 
 		auto func = (PFN_vkCreateDebugUtilsMessengerEXT) vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
@@ -68,10 +68,10 @@ namespace vvh {
 	
 	//---------------------------------------------------------------------------------------------
 
-	inline void DevSetupDebugMessenger(VkInstance instance, VkDebugUtilsMessengerEXT& debugMessenger) {
+	inline void DevSetupDebugMessenger(VkInstance instance, VkDebugUtilsMessengerEXT& debugMessenger, const VkAllocationCallbacks* pAllocator = nullptr) {
 		VkDebugUtilsMessengerCreateInfoEXT createInfo;
 		DevPopulateDebugMessengerCreateInfo(createInfo);
-		if (DevCreateDebugUtilsMessengerEXT( instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS) {
+		if (DevCreateDebugUtilsMessengerEXT( instance, &createInfo, pAllocator, &debugMessenger) != VK_SUCCESS) {
 			throw std::runtime_error("failed to set up debug messenger!");
 		}
 	}
@@ -85,6 +85,7 @@ namespace vvh {
 
 	template<typename T = DevCheckDeviceExtensionSupportInfo>
 	bool DevCheckDeviceExtensionSupport(T&& info) {
+        VVH_ZONE_FUNCTION;
         uint32_t extensionCount;
         vkEnumerateDeviceExtensionProperties(info.m_physicalDevice, nullptr, &extensionCount, nullptr);
 
@@ -102,6 +103,7 @@ namespace vvh {
 
 
 	//---------------------------------------------------------------------------------------------
+	/// Without a surface (headless) there is no present queue, presentFamily then equals graphicsFamily.
 	struct DevFindQueueFamiliesInfo{
 		const VkPhysicalDevice& m_physicalDevice;
 		const VkSurfaceKHR& 	m_surface;
@@ -109,6 +111,7 @@ namespace vvh {
 
 	template<typename T = DevFindQueueFamiliesInfo>
     auto DevFindQueueFamilies(T&& info) -> QueueFamilyIndices {
+        VVH_ZONE_FUNCTION;
         QueueFamilyIndices indices;
 
         uint32_t queueFamilyCount = 0;
@@ -124,7 +127,11 @@ namespace vvh {
             }
 
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(info.m_physicalDevice, i, info.m_surface, &presentSupport);
+            if (info.m_surface == VK_NULL_HANDLE) {
+                presentSupport = indices.graphicsFamily.has_value();
+            } else {
+                vkGetPhysicalDeviceSurfaceSupportKHR(info.m_physicalDevice, i, info.m_surface, &presentSupport);
+            }
 
             if (presentSupport) { indices.presentFamily = i; }
             if (indices.isComplete()) { break; }
@@ -144,6 +151,7 @@ namespace vvh {
 
 	template<typename T = DevQuerySwapChainSupportInfo>
 	auto DevQuerySwapChainSupport(T&& info) -> SwapChainSupportDetails {
+        VVH_ZONE_FUNCTION;
         SwapChainSupportDetails details;
 
         vkGetPhysicalDeviceSurfaceCapabilitiesKHR(info.m_physicalDevice, info.m_surface, &details.capabilities);
@@ -177,12 +185,13 @@ namespace vvh {
 
 	template<typename T = DevIsDeviceSuitableInfo>
     bool DevIsDeviceSuitable(T&& info) {
+        VVH_ZONE_FUNCTION;
         QueueFamilyIndices indices = DevFindQueueFamilies(info);
 
         bool extensionsSupported = DevCheckDeviceExtensionSupport(info);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        bool swapChainAdequate = info.m_surface == VK_NULL_HANDLE; //headless, no swap chain needed
+        if (extensionsSupported && !swapChainAdequate) {
             SwapChainSupportDetails swapChainSupport = DevQuerySwapChainSupport(info);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
@@ -203,10 +212,12 @@ namespace vvh {
 		uint32_t& 			m_apiVersion;
 		bool& 				m_debug; 
 		VkInstance& 		m_instance;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = DevCreateInstanceInfo> 
 	inline void DevCreateInstance(T&& info) {
+        VVH_ZONE_FUNCTION;
         volkInitialize();
 
         if (info.m_debug && !DevCheckValidationLayerSupport(info.m_validationLayers)) {
@@ -244,7 +255,7 @@ namespace vvh {
             createInfo.pNext = nullptr;
         }
 
-        if (vkCreateInstance(&createInfo, nullptr, &info.m_instance) != VK_SUCCESS) {
+        if (vkCreateInstance(&createInfo, info.m_pAllocator, &info.m_instance) != VK_SUCCESS) {
             throw std::runtime_error("failed to create instance!");
         }
         volkInstance = info.m_instance;
@@ -274,6 +285,7 @@ namespace vvh {
 
 	template<typename T = DevDestroyDebugUtilsMessengerEXTInfo> 
 	inline void DevDestroyDebugUtilsMessengerEXT(T&& info) {
+        VVH_ZONE_FUNCTION;
         auto func = (PFN_vkDestroyDebugUtilsMessengerEXT) vkGetInstanceProcAddr(info.m_instance, "vkDestroyDebugUtilsMessengerEXT");
         if (func != nullptr) {
             func(info.m_instance, info.m_debugMessenger, info.m_pAllocator);
@@ -288,21 +300,26 @@ namespace vvh {
 		VkDevice& 			m_device;
 		uint32_t& 			m_apiVersion;
 		VmaAllocator& 		m_vmaAllocator;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		const bool 			m_bufferDeviceAddress{false};	//the device has bufferDeviceAddress enabled
 	};
     
 	template<typename T = DevInitVMAInfo>
 	inline void DevInitVMA(T&& info) {
+        VVH_ZONE_FUNCTION;
         VmaVulkanFunctions vulkanFunctions = {};
         vulkanFunctions.vkGetInstanceProcAddr = vkGetInstanceProcAddr;
         vulkanFunctions.vkGetDeviceProcAddr = vkGetDeviceProcAddr;
 
         VmaAllocatorCreateInfo allocatorCreateInfo = {};
         allocatorCreateInfo.flags = VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+        if( info.m_bufferDeviceAddress ) allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
         allocatorCreateInfo.vulkanApiVersion =  info.m_apiVersion;
         allocatorCreateInfo.physicalDevice = info.m_physicalDevice;
         allocatorCreateInfo.device = info.m_device;
         allocatorCreateInfo.instance = info.m_instance;
         allocatorCreateInfo.pVulkanFunctions = &vulkanFunctions;
+        allocatorCreateInfo.pAllocationCallbacks = info.m_pAllocator;
         vmaCreateAllocator(&allocatorCreateInfo, &info.m_vmaAllocator);
     }
 
@@ -313,11 +330,13 @@ namespace vvh {
 		const VmaAllocator& m_vmaAllocator;
 		const SwapChain& 	m_swapChain;
 		const DepthImage& 	m_depthImage;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
     
 	template<typename T = DevCleanupSwapChainInfo>
     inline void DevCleanupSwapChain(T&& info) {
-        vkDestroyImageView(info.m_device, info.m_depthImage.m_depthImageView, nullptr);
+        VVH_ZONE_FUNCTION;
+        vkDestroyImageView(info.m_device, info.m_depthImage.m_depthImageView, info.m_pAllocator);
 
         ImgDestroyImage({
 			.m_device = info.m_device, 
@@ -327,14 +346,20 @@ namespace vvh {
 		});
 
         for (auto framebuffer : info.m_swapChain.m_swapChainFramebuffers) {
-            vkDestroyFramebuffer(info.m_device, framebuffer, nullptr);
+            vkDestroyFramebuffer(info.m_device, framebuffer, info.m_pAllocator);
         }
 
         for (auto imageView : info.m_swapChain.m_swapChainImageViews) {
-            vkDestroyImageView(info.m_device, imageView, nullptr);
+            vkDestroyImageView(info.m_device, imageView, info.m_pAllocator);
+        }
+
+        if (info.m_swapChain.m_swapChain != VK_NULL_HANDLE) {
+            vkDestroySwapchainKHR(info.m_device, info.m_swapChain.m_swapChain, info.m_pAllocator);
         }
 
-        vkDestroySwapchainKHR(info.m_device, info.m_swapChain.m_swapChain, nullptr);
+        for (size_t i = 0; i < info.m_swapChain.m_swapChainAllocations.size(); i++) {
+            vmaDestroyImage(info.m_vmaAllocator, info.m_swapChain.m_swapChainImages[i], info.m_swapChain.m_swapChainAllocations[i]);
+        }
     }
 
 	//---------------------------------------------------------------------------------------------
@@ -348,10 +373,12 @@ namespace vvh {
 		SwapChain& 			m_swapChain; 
 		DepthImage& 		m_depthImage;
 		VkRenderPass& 		m_renderPass;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
     
 	template<typename T = DevRecreateSwapChainInfo>
 	inline void DevRecreateSwapChain(T&& info) {
+        VVH_ZONE_FUNCTION;
         int width = 0, height = 0;
         
         SDL_GetWindowSize((SDL_Window*)info.m_window, &width, &height);
@@ -376,11 +403,13 @@ namespace vvh {
 		const VkInstance& m_instance;
 		const SDL_Window*& m_window;
 		VkSurfaceKHR& m_surface;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
     
 	template<typename T = DevCreateSurfaceInfo>
 	inline void DevCreateSurface(T&& info) {
-        if (SDL_Vulkan_CreateSurface(info.m_window, info.m_instance, nullptr, &info.m_surface) == 0) {
+        VVH_ZONE_FUNCTION;
+        if (SDL_Vulkan_CreateSurface((SDL_Window*)info.m_window, info.m_instance, info.m_pAllocator, &info.m_surface) == 0) {
             printf("Failed to create Vulkan surface.\n");
         }
     }
@@ -397,6 +426,7 @@ namespace vvh {
 
 	template<typename T = DevPickPhysicalDeviceInfo>
 	inline void DevPickPhysicalDevice(T&& info) {
+        VVH_ZONE_FUNCTION;
 
         uint32_t deviceCount = 0;
         vkEnumeratePhysicalDevices(info.m_instance, &deviceCount, nullptr);
@@ -454,10 +484,13 @@ namespace vvh {
 		VkDevice& 	m_device; 
 		VkQueue& 	m_graphicsQueue;
 		VkQueue& 	m_presentQueue;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		const void* m_pNext{nullptr};	//feature structs to enable, e.g. for extensions
 	};
 
 	template<typename T = DevCreateLogicalDeviceInfo>
 	inline void DevCreateLogicalDevice(T&& info) {
+		VVH_ZONE_FUNCTION;
 
 		info.m_queueFamilies = DevFindQueueFamilies(info);
 
@@ -479,6 +512,7 @@ namespace vvh {
 
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = info.m_pNext;
 
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -497,7 +531,7 @@ namespace vvh {
 			createInfo.enabledLayerCount = 0;
 		}
 
-		if (vkCreateDevice(info.m_physicalDevice, &createInfo, nullptr, &info.m_device) != VK_SUCCESS) {
+		if (vkCreateDevice(info.m_physicalDevice, &createInfo, info.m_pAllocator, &info.m_device) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create logical device!");
 		}
 
@@ -560,10 +594,12 @@ namespace vvh {
 		const VkPhysicalDevice& m_physicalDevice;
 		const VkDevice& 		m_device; 
 		SwapChain& 				m_swapChain;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = DevCreateSwapChainInfo>
 	inline void DevCreateSwapChain(T&& info) {
+        VVH_ZONE_FUNCTION;
         SwapChainSupportDetails swapChainSupport = DevQuerySwapChainSupport(info);
 
         VkSurfaceFormatKHR surfaceFormat = DevChooseSwapSurfaceFormat(swapChainSupport.formats);
@@ -585,6 +621,7 @@ namespace vvh {
         createInfo.imageExtent = extent;
         createInfo.imageArrayLayers = 1;
         createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        createInfo.imageUsage |= swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT; //for readback
 
         QueueFamilyIndices indices = DevFindQueueFamilies(info);
         uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
@@ -602,7 +639,7 @@ namespace vvh {
         createInfo.presentMode = presentMode;
         createInfo.clipped = VK_TRUE;
 
-        if (vkCreateSwapchainKHR(info.m_device, &createInfo, nullptr, &info.m_swapChain.m_swapChain) != VK_SUCCESS) {
+        if (vkCreateSwapchainKHR(info.m_device, &createInfo, info.m_pAllocator, &info.m_swapChain.m_swapChain) != VK_SUCCESS) {
             throw std::runtime_error("failed to create swap chain!");
         }
 
@@ -614,14 +651,66 @@ namespace vvh {
         info.m_swapChain.m_swapChainExtent = extent;
     }
 
+	//---------------------------------------------------------------------------------------------
+	/// Headless mode: a ring of offscreen color images stands in for the swap chain images, so the image view,
+	/// render pass and framebuffer helpers work unchanged. There is no acquire or present, the caller cycles
+	/// through the images. Needs no surface and no VK_KHR_swapchain, e.g. on lavapipe or a render farm node.
+
+	struct DevCreateOffscreenSwapChainInfo {
+		const VkPhysicalDevice& m_physicalDevice;
+		const VkDevice& 		m_device;
+		const VmaAllocator& 	m_vmaAllocator;
+		const VkExtent2D& 		m_extent;
+		SwapChain& 				m_swapChain;
+		const VkFormat 			m_format{VK_FORMAT_R8G8B8A8_SRGB};
+		const uint32_t 			m_imageCount{MAX_FRAMES_IN_FLIGHT + 1};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+	};
+
+	template<typename T = DevCreateOffscreenSwapChainInfo>
+	inline void DevCreateOffscreenSwapChain(T&& info) {
+        VVH_ZONE_FUNCTION;
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(info.m_physicalDevice, info.m_format, &props);
+        if ((props.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT) == 0) {
+            throw std::runtime_error("failed to create offscreen swap chain, format is not a color attachment!");
+        }
+
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT; //for readback
+        info.m_swapChain.m_swapChain = VK_NULL_HANDLE;
+        info.m_swapChain.m_swapChainImages.resize(info.m_imageCount);
+        info.m_swapChain.m_swapChainAllocations.resize(info.m_imageCount);
+        for (uint32_t i = 0; i < info.m_imageCount; i++) {
+            ImgCreateImage2({
+				.m_physicalDevice 	= info.m_physicalDevice, 
+				.m_device 			= info.m_device, 
+				.m_vmaAllocator 	= info.m_vmaAllocator, 
+				.m_width 			= info.m_extent.width, 
+				.m_height 			= info.m_extent.height, 
+				.m_format 			= info.m_format, 
+				.m_tiling 			= VK_IMAGE_TILING_OPTIMAL, 
+				.m_usage 			= usage, 
+				.m_imageLayout 		= VK_IMAGE_LAYOUT_UNDEFINED, 
+				.m_properties 		= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
+				.m_image 			= info.m_swapChain.m_swapChainImages[i], 
+				.m_imageAllocation 	= info.m_swapChain.m_swapChainAllocations[i]
+			});
+        }
+
+        info.m_swapChain.m_swapChainImageFormat = info.m_format;
+        info.m_swapChain.m_swapChainExtent = info.m_extent;
+    }
+
 	//---------------------------------------------------------------------------------------------
     struct DevCreateImageViewsInfo{
 		const VkDevice& m_device;
 		SwapChain& 		m_swapChain;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = DevCreateImageViewsInfo>
     inline void DevCreateImageViews(T&& info) {
+        VVH_ZONE_FUNCTION;
         info.m_swapChain.m_swapChainImageViews.resize(info.m_swapChain.m_swapChainImages.size());
 
         for (uint32_t i = 0; i < info.m_swapChain.m_swapChainImages.size(); i++) {
@@ -629,7 +718,8 @@ namespace vvh {
 					.m_device = info.m_device, 
 					.m_image = info.m_swapChain.m_swapChainImages[i], 
 					.m_format = info.m_swapChain.m_swapChainImageFormat, 
-					.m_aspects = VK_IMAGE_ASPECT_COLOR_BIT
+					.m_aspects = VK_IMAGE_ASPECT_COLOR_BIT,
+					.m_pAllocator = info.m_pAllocator
 				});
         }
     }
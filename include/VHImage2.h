@@ -20,6 +20,7 @@ namespace vvh {
 	
 		template<typename T = ImgTransitionImageLayoutInfo>
 		inline void ImgTransitionImageLayout(T&& info) {
+		   VVH_ZONE_FUNCTION;
 		   VkCommandBuffer commandBuffer = ComBeginSingleTimeCommands(info);
 	
 		   VkImageMemoryBarrier barrier{};
@@ -97,6 +98,7 @@ namespace vvh {
 	
 		template<typename T = ImgTransitionImageLayout2Info>
 		inline void ImgTransitionImageLayout2(T&& info) {
+			VVH_ZONE_FUNCTION;
 			ImgTransitionImageLayout( {
 				info.m_device, 
 				info.m_graphicsQueue, 
@@ -113,16 +115,117 @@ namespace vvh {
     
 	//---------------------------------------------------------------------------------------------
 
+	/// Deduplicates samplers with identical state and counts references to them.
+	/// Devices limit the number of samplers (maxSamplerAllocationCount), while most textures share a few states.
+	/// The physical device properties are queried once in Init() and can be read with Properties().
+	class SamplerCache {
+	public:
+		void Init(VkPhysicalDevice physicalDevice, VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_device = device;
+			m_pAllocator = pAllocator;
+			vkGetPhysicalDeviceProperties(physicalDevice, &m_properties);
+		}
+
+		/// @brief Return a sampler for the given state, creating it if needed. pNext chains are not supported.
+		auto Acquire(const VkSamplerCreateInfo& createInfo) -> VkSampler {
+			assert(createInfo.pNext == nullptr);
+			Key key = MakeKey(createInfo);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_entries.find(key);
+			if( it != m_entries.end() ) {
+				++it->second.m_refCount;
+				return it->second.m_sampler;
+			}
+			if( m_samplers.size() >= m_properties.limits.maxSamplerAllocationCount ) {
+				throw std::runtime_error("failed to create texture sampler, too many samplers!");
+			}
+			VkSampler sampler;
+			if (vkCreateSampler(m_device, &createInfo, m_pAllocator, &sampler) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create texture sampler!");
+			}
+			m_entries[key] = { sampler, 1 };
+			m_samplers[sampler] = key;
+			return sampler;
+		}
+
+		/// @brief Drop a reference, the sampler is destroyed when the last one is gone. Samplers that were not
+		/// acquired from the cache, e.g. created by ImgCreateTextureSampler() without a cache, are destroyed right away.
+		void Release(VkSampler sampler) {
+			if( sampler == VK_NULL_HANDLE ) return;
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_samplers.find(sampler);
+			if( it == m_samplers.end() ) {
+				vkDestroySampler(m_device, sampler, m_pAllocator);
+				return;
+			}
+			auto entry = m_entries.find(it->second);
+			if( --entry->second.m_refCount > 0 ) return;
+			vkDestroySampler(m_device, sampler, m_pAllocator);
+			m_entries.erase(entry);
+			m_samplers.erase(it);
+		}
+
+		/// @brief Destroy all samplers, call before destroying the device.
+		void Destroy() {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for( auto& [sampler, key] : m_samplers ) vkDestroySampler(m_device, sampler, m_pAllocator);
+			m_entries.clear();
+			m_samplers.clear();
+		}
+
+		auto Properties() const -> const VkPhysicalDeviceProperties& { return m_properties; }
+		auto Size() -> size_t { std::lock_guard<std::mutex> lock(m_mutex); return m_samplers.size(); }
+
+	private:
+		//the sampler state without sType and pNext, floats stored as bit patterns
+		using Key = std::array<uint32_t, 16>;
+
+		struct KeyHash {
+			size_t operator()(const Key& key) const {
+				uint64_t hash = 14695981039346656037ull;	//FNV-1a
+				for( auto value : key ) { hash ^= value; hash *= 1099511628211ull; }
+				return (size_t)hash;
+			}
+		};
+
+		struct Entry {
+			VkSampler 	m_sampler;
+			uint32_t 	m_refCount;
+		};
+
+		static auto MakeKey(const VkSamplerCreateInfo& ci) -> Key {
+			auto bits = [](float f) { uint32_t u; memcpy(&u, &f, sizeof(u)); return u; };
+			return { ci.flags, (uint32_t)ci.magFilter, (uint32_t)ci.minFilter, (uint32_t)ci.mipmapMode,
+				(uint32_t)ci.addressModeU, (uint32_t)ci.addressModeV, (uint32_t)ci.addressModeW, bits(ci.mipLodBias),
+				ci.anisotropyEnable, bits(ci.maxAnisotropy), ci.compareEnable, (uint32_t)ci.compareOp,
+				bits(ci.minLod), bits(ci.maxLod), (uint32_t)ci.borderColor, ci.unnormalizedCoordinates };
+		}
+
+		VkDevice 						m_device{VK_NULL_HANDLE};
+		const VkAllocationCallbacks* 	m_pAllocator{nullptr};
+		VkPhysicalDeviceProperties 		m_properties{};
+		std::mutex 						m_mutex;
+		std::unordered_map<Key, Entry, KeyHash> m_entries;
+		std::unordered_map<VkSampler, Key> 		m_samplers;
+	};
+
+	//---------------------------------------------------------------------------------------------
+
 	struct ImgCreateTextureSamplerInfo {
 		const VkPhysicalDevice& m_physicalDevice;
 		const VkDevice& 		m_device;
 		Image& 					m_texture;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		SamplerCache* 			m_samplerCache{nullptr};
 	};
 
+	/// @brief Create the texture sampler. With a cache the sampler is shared, release it with SamplerCache::Release().
 	template<typename T = ImgCreateTextureSamplerInfo>
 	inline void ImgCreateTextureSampler(T&& info) {
+		VVH_ZONE_FUNCTION;
 		VkPhysicalDeviceProperties properties{};
-		vkGetPhysicalDeviceProperties(info.m_physicalDevice, &properties);
+		if( info.m_samplerCache ) properties = info.m_samplerCache->Properties();
+		else vkGetPhysicalDeviceProperties(info.m_physicalDevice, &properties);
   
 		VkSamplerCreateInfo samplerInfo{};
 		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -138,8 +241,14 @@ namespace vvh {
 		samplerInfo.compareEnable = VK_FALSE;
 		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-  
-		if (vkCreateSampler(info.m_device, &samplerInfo, nullptr, &info.m_texture.m_mapSampler) != VK_SUCCESS) {
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;	//the image view limits the mip levels, so textures can share samplers
+
+		if( info.m_samplerCache ) {
+			info.m_texture.m_mapSampler = info.m_samplerCache->Acquire(samplerInfo);
+			return;
+		}
+		if (vkCreateSampler(info.m_device, &samplerInfo, info.m_pAllocator, &info.m_texture.m_mapSampler) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create texture sampler!");
 		}
 	}
@@ -154,14 +263,17 @@ namespace vvh {
 		const VkImageAspectFlags& 	m_aspects;
 		const uint32_t& 			m_layers;
 		const uint32_t& 			m_mipLevels;
+		const VkImageViewType 		m_viewType{VK_IMAGE_VIEW_TYPE_2D};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	}; 
 	
 	template<typename T = ImgCreateImageViewInfo>
 	auto ImgCreateImageView(T&& info) -> VkImageView {
+        VVH_ZONE_FUNCTION;
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         viewInfo.image = info.m_image;
-        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.viewType = info.m_viewType;
         viewInfo.format = info.m_format;
         viewInfo.subresourceRange.aspectMask = info.m_aspects;
         viewInfo.subresourceRange.baseMipLevel = 0;
@@ -170,7 +282,7 @@ namespace vvh {
         viewInfo.subresourceRange.layerCount = info.m_layers;
 
         VkImageView imageView;
-        if (vkCreateImageView(info.m_device, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+        if (vkCreateImageView(info.m_device, &viewInfo, info.m_pAllocator, &imageView) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image view!");
         }
 
@@ -185,17 +297,20 @@ namespace vvh {
 		const VkImage& 		m_image;
 		const VkFormat& 	m_format;
 		const VkImageAspectFlags& m_aspects;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = ImgCreateImageView2Info>
 	inline auto ImgCreateImageView2(T&& info) -> VkImageView {
+		VVH_ZONE_FUNCTION;
 		return ImgCreateImageView({
 			.m_device 		= info.m_device, 
 			.m_image 		= info.m_image, 
 			.m_format 		= info.m_format, 
 			.m_aspects 		= info.m_aspects, 
 			.m_layers 		= 1, 
-			.m_mipLevels 	= 1 
+			.m_mipLevels 	= 1,
+			.m_pAllocator 	= info.m_pAllocator
 		});
 	}
 	
@@ -204,15 +319,20 @@ namespace vvh {
 	struct ImgCreateTextureImageViewinfo {
 		const VkDevice& m_device;
 		Image& m_texture;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 	
 	template<typename T = ImgCreateTextureImageViewinfo>
 	inline void ImgCreateTextureImageView(T&& info) {
-		info.m_texture.m_mapImageView = ImgCreateImageView2({
-			.m_device 	= info.m_device, 
-			.m_image 	= info.m_texture.m_mapImage, 
-			.m_format 	= VK_FORMAT_R8G8B8A8_SRGB,
-			.m_aspects 	= VK_IMAGE_ASPECT_COLOR_BIT
+		VVH_ZONE_FUNCTION;
+		info.m_texture.m_mapImageView = ImgCreateImageView({
+			.m_device 		= info.m_device, 
+			.m_image 		= info.m_texture.m_mapImage, 
+			.m_format 		= VK_FORMAT_R8G8B8A8_SRGB,
+			.m_aspects 		= VK_IMAGE_ASPECT_COLOR_BIT,
+			.m_layers 		= 1,
+			.m_mipLevels 	= info.m_texture.m_mipLevels,
+			.m_pAllocator 	= info.m_pAllocator
 		});
 	}
 	  
@@ -234,12 +354,15 @@ namespace vvh {
 		const VkMemoryPropertyFlags& m_properties; 
 		VkImage& 		m_image; 
 		VmaAllocation& 	m_imageAllocation;
+		const VkImageCreateFlags m_flags{0};
 	};
 
 	template<typename T = ImgCreateImageInfo>
 	inline void ImgCreateImage(T&& info) {
+		VVH_ZONE_FUNCTION;
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType 		= VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.flags 		= info.m_flags;
 		imageInfo.imageType		= VK_IMAGE_TYPE_2D;
 		imageInfo.extent.width 	= info.m_width;
 		imageInfo.extent.height = info.m_height;
@@ -279,6 +402,7 @@ namespace vvh {
 
 	template<typename T = ImgCreateImage2Info>
 	inline void ImgCreateImage2(T&& info) {
+			VVH_ZONE_FUNCTION;
 			return ImgCreateImage({
 					.m_physicalDevice 	= info.m_physicalDevice, 
 					.m_device 			= info.m_device, 
@@ -298,6 +422,286 @@ namespace vvh {
 				});
 	}
 
+	//---------------------------------------------------------------------------------------------
+
+	inline auto ImgMipLevels(uint32_t width, uint32_t height) -> uint32_t {
+		uint32_t levels = 1;
+		for( uint32_t size = std::max(width, height); size > 1; size >>= 1 ) ++levels;
+		return levels;
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	struct ImgGenerateMipmapsInfo {
+		const VkCommandBuffer& 	m_commandBuffer;
+		const VkImage& 			m_image;
+		const uint32_t& 		m_width;
+		const uint32_t& 		m_height;
+		const uint32_t& 		m_mipLevels;
+		const uint32_t& 		m_layers;
+	};
+
+	/// @brief Record a vkCmdBlitImage chain that fills mip levels 1..n-1 from level 0.
+	/// All levels must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, afterwards they are in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+	template<typename T = ImgGenerateMipmapsInfo>
+	inline void ImgGenerateMipmaps(T&& info) {
+		VVH_ZONE_FUNCTION;
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.image = info.m_image;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = info.m_layers;
+		barrier.subresourceRange.levelCount = 1;
+
+		int32_t mipWidth = (int32_t)info.m_width;
+		int32_t mipHeight = (int32_t)info.m_height;
+
+		for (uint32_t i = 1; i < info.m_mipLevels; i++) {
+			barrier.subresourceRange.baseMipLevel = i - 1;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(info.m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkImageBlit blit{};
+			blit.srcOffsets[0] = {0, 0, 0};
+			blit.srcOffsets[1] = {mipWidth, mipHeight, 1};
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = i - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = info.m_layers;
+			blit.dstOffsets[0] = {0, 0, 0};
+			blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = i;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = info.m_layers;
+			vkCmdBlitImage(info.m_commandBuffer, info.m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				info.m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(info.m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+				0, nullptr, 0, nullptr, 1, &barrier);
+
+			if (mipWidth > 1) mipWidth /= 2;
+			if (mipHeight > 1) mipHeight /= 2;
+		}
+
+		barrier.subresourceRange.baseMipLevel = info.m_mipLevels - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(info.m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	struct ImgCreateMipmapPipelineInfo {
+		const VkDevice& 	m_device;
+		const std::string& 	m_shaderPath;		//SPIR-V of shader/mipmap.slang
+		MipmapPipeline& 	m_mipmapPipeline;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		const VkPipelineCache m_pipelineCache{VK_NULL_HANDLE};
+	};
+
+	template<typename T = ImgCreateMipmapPipelineInfo>
+	inline void ImgCreateMipmapPipeline(T&& info) {
+		VVH_ZONE_FUNCTION;
+		std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+		for( uint32_t i = 0; i < bindings.size(); ++i ) {
+			bindings[i].binding = i;
+			bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			bindings[i].descriptorCount = 1;
+			bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = (uint32_t)bindings.size();
+		layoutInfo.pBindings = bindings.data();
+		if (vkCreateDescriptorSetLayout(info.m_device, &layoutInfo, info.m_pAllocator, &info.m_mipmapPipeline.m_descriptorSetLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create mipmap descriptor set layout!");
+		}
+
+		VkPushConstantRange pushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, 4 * sizeof(uint32_t) };
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &info.m_mipmapPipeline.m_descriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(info.m_device, &pipelineLayoutInfo, info.m_pAllocator, &info.m_mipmapPipeline.m_pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create mipmap pipeline layout!");
+		}
+
+		FileView code(info.m_shaderPath);
+		VkShaderModuleCreateInfo moduleInfo{};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = code.Size();
+		moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.Data());
+		VkShaderModule shaderModule;
+		if (vkCreateShaderModule(info.m_device, &moduleInfo, info.m_pAllocator, &shaderModule) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shader module!");
+		}
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = shaderModule;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = info.m_mipmapPipeline.m_pipelineLayout;
+		VkResult result = vkCreateComputePipelines(info.m_device, info.m_pipelineCache, 1, &pipelineInfo, info.m_pAllocator, &info.m_mipmapPipeline.m_pipeline);
+		vkDestroyShaderModule(info.m_device, shaderModule, info.m_pAllocator);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("failed to create mipmap pipeline!");
+		}
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	struct ImgDestroyMipmapPipelineInfo {
+		const VkDevice& 		m_device;
+		const MipmapPipeline& 	m_mipmapPipeline;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+	};
+
+	template<typename T = ImgDestroyMipmapPipelineInfo>
+	inline void ImgDestroyMipmapPipeline(T&& info) {
+		VVH_ZONE_FUNCTION;
+		vkDestroyPipeline(info.m_device, info.m_mipmapPipeline.m_pipeline, info.m_pAllocator);
+		vkDestroyPipelineLayout(info.m_device, info.m_mipmapPipeline.m_pipelineLayout, info.m_pAllocator);
+		vkDestroyDescriptorSetLayout(info.m_device, info.m_mipmapPipeline.m_descriptorSetLayout, info.m_pAllocator);
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	struct ImgGenerateMipmapsComputeInfo {
+		const VkDevice& 		m_device;
+		const VkCommandBuffer& 	m_commandBuffer;
+		const VkImage& 			m_image;
+		const VkFormat& 		m_storageFormat;	//UNORM format the levels are viewed as
+		const bool& 			m_srgb;				//encode/decode sRGB in the shader
+		const uint32_t& 		m_width;
+		const uint32_t& 		m_height;
+		const uint32_t& 		m_mipLevels;
+		const MipmapPipeline& 	m_mipmapPipeline;
+		std::vector<VkImageView>& m_views;			//per level views, destroy after the command buffer completed
+		VkDescriptorPool& 		m_descriptorPool;	//destroy after the command buffer completed
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+	};
+
+	/// @brief Compute shader fallback of ImgGenerateMipmaps for formats without linear blit support.
+	/// The image must have been created with VK_IMAGE_USAGE_STORAGE_BIT and VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT.
+	/// Layouts on entry and exit are the same as for ImgGenerateMipmaps.
+	template<typename T = ImgGenerateMipmapsComputeInfo>
+	inline void ImgGenerateMipmapsCompute(T&& info) {
+		VVH_ZONE_FUNCTION;
+		uint32_t setCount = info.m_mipLevels - 1;
+
+		VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 * setCount };
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.maxSets = setCount;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		if (vkCreateDescriptorPool(info.m_device, &poolInfo, info.m_pAllocator, &info.m_descriptorPool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create mipmap descriptor pool!");
+		}
+
+		std::vector<VkDescriptorSetLayout> layouts(setCount, info.m_mipmapPipeline.m_descriptorSetLayout);
+		std::vector<VkDescriptorSet> sets(setCount);
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = info.m_descriptorPool;
+		allocInfo.descriptorSetCount = setCount;
+		allocInfo.pSetLayouts = layouts.data();
+		if (vkAllocateDescriptorSets(info.m_device, &allocInfo, sets.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate mipmap descriptor sets!");
+		}
+
+		info.m_views.resize(info.m_mipLevels);
+		for( uint32_t i = 0; i < info.m_mipLevels; ++i ) {
+			VkImageViewCreateInfo viewInfo{};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = info.m_image;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = info.m_storageFormat;
+			viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+			if (vkCreateImageView(info.m_device, &viewInfo, info.m_pAllocator, &info.m_views[i]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create image view!");
+			}
+		}
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.image = info.m_image;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, info.m_mipLevels, 0, 1 };
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(info.m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &barrier);
+
+		vkCmdBindPipeline(info.m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, info.m_mipmapPipeline.m_pipeline);
+
+		uint32_t mipWidth = info.m_width, mipHeight = info.m_height;
+		for( uint32_t i = 1; i < info.m_mipLevels; ++i ) {
+			std::array<VkDescriptorImageInfo, 2> imageInfos{};
+			imageInfos[0] = { VK_NULL_HANDLE, info.m_views[i - 1], VK_IMAGE_LAYOUT_GENERAL };
+			imageInfos[1] = { VK_NULL_HANDLE, info.m_views[i], VK_IMAGE_LAYOUT_GENERAL };
+			std::array<VkWriteDescriptorSet, 2> writes{};
+			for( uint32_t j = 0; j < writes.size(); ++j ) {
+				writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writes[j].dstSet = sets[i - 1];
+				writes[j].dstBinding = j;
+				writes[j].descriptorCount = 1;
+				writes[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+				writes[j].pImageInfo = &imageInfos[j];
+			}
+			vkUpdateDescriptorSets(info.m_device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+
+			if (mipWidth > 1) mipWidth /= 2;
+			if (mipHeight > 1) mipHeight /= 2;
+
+			std::array<uint32_t, 4> params{ mipWidth, mipHeight, info.m_srgb ? 1u : 0u, 0u };
+			vkCmdBindDescriptorSets(info.m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, info.m_mipmapPipeline.m_pipelineLayout, 
+				0, 1, &sets[i - 1], 0, nullptr);
+			vkCmdPushConstants(info.m_commandBuffer, info.m_mipmapPipeline.m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 
+				0, (uint32_t)sizeof(params), params.data());
+			vkCmdDispatch(info.m_commandBuffer, (mipWidth + 7) / 8, (mipHeight + 7) / 8, 1);
+
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+			barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(info.m_commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+				0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, info.m_mipLevels, 0, 1 };
+		barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(info.m_commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
 	//---------------------------------------------------------------------------------------------
 	
 	struct ImgCreateTextureImageInfo {
@@ -311,10 +715,39 @@ namespace vvh {
 		const int& 				m_height;
 		const size_t& 			m_size;
 		Image& 					m_texture;
+		const bool 				m_generateMipmaps{true};
+		const MipmapPipeline* 	m_mipmapPipeline{nullptr};	//compute fallback if the format does not support linear blits
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
+	/// @brief Upload RGBA8 pixels into a sampled texture. Upload, mip chain generation and all layout transitions
+	/// are recorded into a single command buffer. Without linear blit support and without m_mipmapPipeline 
+	/// the texture gets a single mip level.
 	template<typename T = ImgCreateTextureImageInfo>
 	inline void ImgCreateTextureImage(T&& info) {
+		VVH_ZONE_FUNCTION;
+		const VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+		const VkFormat storageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		uint32_t width = (uint32_t)info.m_width;
+		uint32_t height = (uint32_t)info.m_height;
+
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(info.m_physicalDevice, format, &formatProperties);
+		const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT 
+			| VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		bool useBlit = (formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures;
+		bool useCompute = !useBlit && info.m_mipmapPipeline != nullptr && info.m_mipmapPipeline->m_pipeline != VK_NULL_HANDLE;
+
+		uint32_t mipLevels = info.m_generateMipmaps && (useBlit || useCompute) ? ImgMipLevels(width, height) : 1;
+		if( mipLevels == 1 ) useBlit = useCompute = false;
+		info.m_texture.m_mipLevels = mipLevels;
+
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		VkImageCreateFlags flags = 0;
+		if( useCompute ) {
+			usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+			flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+		}
 
         VkBuffer stagingBuffer;
         VmaAllocation stagingBufferAllocation;
@@ -332,51 +765,77 @@ namespace vvh {
 
         memcpy(allocInfo.pMappedData, info.m_pixels, info.m_size);
 
-        ImgCreateImage2({
-			info.m_physicalDevice, 
-			info.m_device, 
-			info.m_vmaAllocator, 
-			(uint32_t)info.m_width, 
-			(uint32_t)info.m_height, 
-			VK_FORMAT_R8G8B8A8_SRGB, 
-			VK_IMAGE_TILING_OPTIMAL, 
-			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			info.m_texture.m_mapImage,
-			info.m_texture.m_mapImageAllocation
-		}); 
-		
-        ImgTransitionImageLayout2({
-			info.m_device, 
-			info.m_graphicsQueue, 
-			info.m_commandPool, 
-			info.m_texture.m_mapImage, 
-			VK_FORMAT_R8G8B8A8_SRGB, 
-			VK_IMAGE_LAYOUT_UNDEFINED, 
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-		});
-    
-        BufCopyBufferToImage({
+        ImgCreateImage({
+			.m_physicalDevice 	= info.m_physicalDevice, 
 			.m_device 			= info.m_device, 
-			.m_graphicsQueue 	= info.m_graphicsQueue, 
-			.m_commandPool 		= info.m_commandPool, 
-			.m_buffer 			= stagingBuffer, 
+			.m_vmaAllocator 	= info.m_vmaAllocator, 
+			.m_width 			= width, 
+			.m_height 			= height, 
+			.m_depth 			= 1, 
+			.m_layers 			= 1, 
+			.m_mipLevels 		= mipLevels, 
+			.m_format 			= format, 
+			.m_tiling 			= VK_IMAGE_TILING_OPTIMAL, 
+			.m_usage 			= usage,
+			.m_imageLayout 		= VK_IMAGE_LAYOUT_UNDEFINED, 
+			.m_properties 		= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
 			.m_image 			= info.m_texture.m_mapImage, 
-			.m_width 			= static_cast<uint32_t>(info.m_width), 
-			.m_height 			= static_cast<uint32_t>(info.m_height)
-		});
+			.m_imageAllocation 	= info.m_texture.m_mapImageAllocation,
+			.m_flags 			= flags
+		}); 
 
-        ImgTransitionImageLayout2({
-			info.m_device, 
-			info.m_graphicsQueue, 
-			info.m_commandPool, 
-			info.m_texture.m_mapImage, 
-			VK_FORMAT_R8G8B8A8_SRGB, 
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		});
+		VkCommandBuffer commandBuffer = ComBeginSingleTimeCommands(info);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = info.m_texture.m_mapImage;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 };
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy region{};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { width, height, 1 };
+		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, info.m_texture.m_mapImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		std::vector<VkImageView> levelViews;
+		VkDescriptorPool descriptorPool{VK_NULL_HANDLE};
+		if( useBlit ) {
+			ImgGenerateMipmaps({ commandBuffer, info.m_texture.m_mapImage, width, height, mipLevels, 1 });
+		} else if( useCompute ) {
+			ImgGenerateMipmapsCompute({
+				.m_device 			= info.m_device,
+				.m_commandBuffer 	= commandBuffer,
+				.m_image 			= info.m_texture.m_mapImage,
+				.m_storageFormat 	= storageFormat,
+				.m_srgb 			= true,
+				.m_width 			= width,
+				.m_height 			= height,
+				.m_mipLevels 		= mipLevels,
+				.m_mipmapPipeline 	= *info.m_mipmapPipeline,
+				.m_views 			= levelViews,
+				.m_descriptorPool 	= descriptorPool,
+				.m_pAllocator 		= info.m_pAllocator
+			});
+		} else {
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+				0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		ComEndSingleTimeCommands({info.m_device, info.m_graphicsQueue, info.m_commandPool, commandBuffer});
 
+		for( auto view : levelViews ) vkDestroyImageView(info.m_device, view, info.m_pAllocator);
+		if( descriptorPool != VK_NULL_HANDLE ) vkDestroyDescriptorPool(info.m_device, descriptorPool, info.m_pAllocator);
         BufDestroyBuffer({info.m_device, info.m_vmaAllocator, stagingBuffer, stagingBufferAllocation});
     }
 
@@ -391,6 +850,7 @@ namespace vvh {
 
 	template<typename T = ImgDestroyImageInfo>
     inline void ImgDestroyImage(T&& info) {
+        VVH_ZONE_FUNCTION;
         vmaDestroyImage(info.m_vmaAllocator, info.m_image, info.m_imageAllocation);
     }
 
@@ -407,20 +867,12 @@ namespace vvh {
 		int& m_height;
 	};
 
+	/// @brief Move source channel 0..3 of each pixel to position m_r, m_g, m_b, m_a, in place.
 	template<typename T = ImgSwapChannelsInfo>
 	inline void ImgSwapChannels(T&& info) {
-		for (uint32_t i = 0; i < info.m_width * info.m_height; i++)
-		{
-			unsigned char rc = info.m_bufferData[4 * i + 0];
-			unsigned char gc = info.m_bufferData[4 * i + 1];
-			unsigned char bc = info.m_bufferData[4 * i + 2];
-			unsigned char ac = info.m_bufferData[4 * i + 3];
-
-			info.m_bufferData[4 * i + info.m_r] = rc;
-			info.m_bufferData[4 * i + info.m_g] = gc;
-			info.m_bufferData[4 * i + info.m_b] = bc;
-			info.m_bufferData[4 * i + info.m_a] = ac;
-		}
+		VVH_ZONE_FUNCTION;
+		SwzSwizzle(info.m_bufferData, info.m_bufferData, (size_t)info.m_width * info.m_height,
+			SwzPatternFromPositions(info.m_r, info.m_g, info.m_b, info.m_a));
 	}
 
 	//---------------------------------------------------------------------------------------------
@@ -442,10 +894,13 @@ namespace vvh {
 		const int& 		m_g; 
 		const int& 		m_b; 
 		const int& 		m_a;
+		const uint32_t 	m_channels{4};	//3 drops the alpha channel, m_bufferData then holds 3 bytes per pixel
 	};
     
+	/// @brief Copy an 8 bit, 4 channel image to host memory. The channels are reordered while copying out of the staging buffer.
 	template<typename T = ImgCopyImageToHostinfo>
 	inline auto ImgCopyImageToHost(T&& info) -> VkResult {
+		VVH_ZONE_FUNCTION;
 
 		VkBuffer stagingBuffer;
 		VmaAllocation stagingBufferAllocation;
@@ -455,8 +910,8 @@ namespace vvh {
 			.m_vmaAllocator = info.m_vmaAllocator, 
 			.m_size = info.m_size, 
 			.m_usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
-			.m_vmaFlags = VMA_MEMORY_USAGE_CPU_ONLY, 
-			.m_properties = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+			.m_properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, 
+			.m_vmaFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT, //cached memory for CPU reads
             .m_buffer = stagingBuffer, 
 			.m_allocation = stagingBufferAllocation, 
 			.m_allocationInfo = &allocInfo
@@ -494,12 +949,9 @@ namespace vvh {
 			.m_newLayout = info.m_layout
 		});
 
-		void *data;
-		vmaMapMemory( info.m_vmaAllocator, stagingBufferAllocation, &data);
-		memcpy(info.m_bufferData, data, (size_t)info.m_size);
-		vmaUnmapMemory( info.m_vmaAllocator, stagingBufferAllocation);
-
-		vvh::ImgSwapChannels(info);
+		vmaInvalidateAllocation( info.m_vmaAllocator, stagingBufferAllocation, 0, VK_WHOLE_SIZE);
+		SwzSwizzle(allocInfo.pMappedData, info.m_bufferData, (size_t)info.m_width * info.m_height,
+			SwzPatternFromPositions(info.m_r, info.m_g, info.m_b, info.m_a, info.m_channels));
 
 		vmaDestroyBuffer( info.m_vmaAllocator, stagingBuffer, stagingBufferAllocation);
 		return VK_SUCCESS;
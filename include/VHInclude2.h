@@ -52,7 +52,7 @@ namespace vvh {
 
     inline void SetupImgui(SDL_Window* sdlWindow, VkInstance instance, VkPhysicalDevice physicalDevice, QueueFamilyIndices queueFamilies
         , VkDevice device, VkQueue graphicsQueue, VkCommandPool commandPool, VkDescriptorPool descriptorPool
-        , VkRenderPass renderPass) {
+        , VkRenderPass renderPass, const VkAllocationCallbacks* pAllocator = nullptr, VkPipelineCache pipelineCache = VK_NULL_HANDLE) {
             
         // Setup Dear ImGui context
         IMGUI_CHECKVERSION();
@@ -73,14 +73,14 @@ namespace vvh {
         init_info.Device = device;
         init_info.QueueFamily = queueFamilies.graphicsFamily.value();
         init_info.Queue = graphicsQueue;
-        init_info.PipelineCache = VK_NULL_HANDLE;
+        init_info.PipelineCache = pipelineCache;
         init_info.DescriptorPool = descriptorPool;
         init_info.RenderPass = renderPass;
         init_info.Subpass = 0;
         init_info.MinImageCount = 3;
         init_info.ImageCount = 3;
         init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-        init_info.Allocator = nullptr;
+        init_info.Allocator = pAllocator;
         init_info.CheckVkResultFn = nullptr;
         ImGui_ImplVulkan_Init(&init_info);
         // (this gets a bit more complicated, see example app for full reference)
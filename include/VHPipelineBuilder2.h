@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <future>
+#include <mutex>
+#include <algorithm>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Builds graphics pipelines on a thread pool. Submit copies the description and returns a future, so the
+	// caller can keep drawing with a fallback pipeline until Select() sees the real one ready. Shader modules
+	// come from a ShaderLibrary, so builds sharing a shader read it only once. Pass a PipelineCache handle to
+	// share compiled state between builds and across runs.
+
+	struct PipelineDesc {
+		VkRenderPass 	m_renderPass{VK_NULL_HANDLE};
+		std::string 	m_vertShaderPath;
+		std::string 	m_fragShaderPath;
+		std::vector<VkVertexInputBindingDescription> 	m_bindingDescription;
+		std::vector<VkVertexInputAttributeDescription> 	m_attributeDescriptions;
+		std::vector<VkDescriptorSetLayout> 				m_descriptorSetLayouts;
+		std::vector<int32_t> 							m_specializationConstants;
+		std::vector<VkPushConstantRange> 				m_pushConstantRanges;
+		std::vector<VkPipelineColorBlendAttachmentState> m_blendAttachments;
+		VkBool32 			m_depthTest{VK_TRUE};
+		VkBool32 			m_depthWrite{VK_TRUE};
+		VkCullModeFlags 	m_cullMode{VK_CULL_MODE_BACK_BIT};
+		VkPipelineLayout 	m_pipelineLayout{VK_NULL_HANDLE};	//shared layout, not owned by the built pipeline
+		VkPipelineCreateFlags m_flags{0};
+	};
+
+	class PipelineBuilder {
+	public:
+		using Future = std::shared_future<Pipeline>;
+
+		void Init(ThreadPool& pool, ShaderLibrary& library, VkDevice device, VkPipelineCache pipelineCache = VK_NULL_HANDLE,
+					const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_pool = &pool;
+			m_library = &library;
+			m_device = device;
+			m_pipelineCache = pipelineCache;
+			m_pAllocator = pAllocator;
+		}
+
+		/// @brief Wait for all builds. The pipelines belong to the callers, the modules to the library.
+		void Destroy() {
+			Wait();
+		}
+
+		/// @brief Queue a build. Errors are rethrown by the future's get().
+		auto Submit(PipelineDesc desc) -> Future {
+			Future future = m_pool->Submit([this, desc = std::move(desc)]() { return Build(desc); }).share();
+			std::lock_guard<std::mutex> lock(m_mutex);
+			std::erase_if(m_builds, [](auto& build) { return build.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+			m_builds.push_back(future);
+			return future;
+		}
+
+		/// @brief The built pipeline if it is ready, otherwise the fallback. Never blocks.
+		static auto Select(const Future& future, const Pipeline& fallback) -> const Pipeline& {
+			if( !future.valid() || future.wait_for(std::chrono::seconds(0)) != std::future_status::ready ) return fallback;
+			return future.get();
+		}
+
+		/// @brief Block until all submitted builds have finished.
+		void Wait() {
+			std::vector<Future> builds;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				builds.swap(m_builds);
+			}
+			for( auto& build : builds ) build.wait();
+		}
+
+		auto Pending() -> size_t {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return std::count_if(m_builds.begin(), m_builds.end(),
+				[](auto& build) { return build.wait_for(std::chrono::seconds(0)) != std::future_status::ready; });
+		}
+
+	private:
+		auto Build(const PipelineDesc& desc) -> Pipeline {
+			VVH_ZONE("PipelineBuilder::Build");
+			VkShaderModule vert = m_library->Load(desc.m_vertShaderPath);
+			VkShaderModule frag = desc.m_fragShaderPath.empty() ? VK_NULL_HANDLE : m_library->Load(desc.m_fragShaderPath);
+			Pipeline pipeline{};
+			RenCreateGraphicsPipeline({
+				.m_device 					= m_device,
+				.m_renderPass 				= desc.m_renderPass,
+				.m_vertShaderPath 			= desc.m_vertShaderPath,
+				.m_fragShaderPath 			= desc.m_fragShaderPath,
+				.m_bindingDescription 		= desc.m_bindingDescription,
+				.m_attributeDescriptions 	= desc.m_attributeDescriptions,
+				.m_descriptorSetLayouts 	= desc.m_descriptorSetLayouts,
+				.m_specializationConstants 	= desc.m_specializationConstants,
+				.m_pushConstantRanges 		= desc.m_pushConstantRanges,
+				.m_blendAttachments 		= desc.m_blendAttachments,
+				.m_graphicsPipeline 		= pipeline,
+				.m_pAllocator 				= m_pAllocator,
+				.m_pipelineCache 			= m_pipelineCache,
+				.m_vertShaderModule 		= vert,
+				.m_fragShaderModule 		= frag,
+				.m_depthTest 				= desc.m_depthTest,
+				.m_depthWrite 				= desc.m_depthWrite,
+				.m_cullMode 				= desc.m_cullMode,
+				.m_pipelineLayout 			= desc.m_pipelineLayout,
+				.m_flags 					= desc.m_flags
+			});
+			return pipeline;
+		}
+
+		ThreadPool* 			m_pool{nullptr};
+		ShaderLibrary* 			m_library{nullptr};
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		VkPipelineCache 		m_pipelineCache{VK_NULL_HANDLE};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		std::mutex 				m_mutex;
+		std::vector<Future> 	m_builds;
+	};
+
+} // namespace vvh
+
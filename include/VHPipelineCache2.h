@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// A VkPipelineCache that persists across runs. Init loads the blob written by the last run if its header
+	// matches this device and driver, otherwise the cache starts empty. Pass Handle() to every pipeline creation,
+	// the cache is internally synchronized so worker threads may share it. The blob is written to a temporary
+	// file that is then renamed over the old one, so a crash while saving never leaves a truncated cache.
+
+	class PipelineCache {
+	public:
+		void Init(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path, const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_device = device;
+			m_path = path;
+			m_pAllocator = pAllocator;
+			vkGetPhysicalDeviceProperties(physicalDevice, &m_properties);
+
+			std::vector<char> data = Load();
+			VkPipelineCacheCreateInfo cacheInfo{};
+			cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+			cacheInfo.initialDataSize = data.size();
+			cacheInfo.pInitialData = data.data();
+			m_savedSize = data.size();
+			if (vkCreatePipelineCache(m_device, &cacheInfo, m_pAllocator, &m_cache) != VK_SUCCESS) {
+				//the driver may still reject a blob with a valid header, start empty then
+				cacheInfo.initialDataSize = 0;
+				cacheInfo.pInitialData = nullptr;
+				m_savedSize = 0;
+				if (vkCreatePipelineCache(m_device, &cacheInfo, m_pAllocator, &m_cache) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create pipeline cache!");
+				}
+			}
+			m_lastSave = std::chrono::steady_clock::now();
+		}
+
+		/// @brief Save and destroy the cache. Call after all pipeline creation has finished.
+		void Destroy() {
+			if( m_cache == VK_NULL_HANDLE ) return;
+			Save();
+			vkDestroyPipelineCache(m_device, m_cache, m_pAllocator);
+			m_cache = VK_NULL_HANDLE;
+		}
+
+		auto Handle() const -> VkPipelineCache { return m_cache; }
+
+		/// @brief Write the cache to disk if it grew since the last save. Returns true if a file was written.
+		bool Save() {
+			if( m_cache == VK_NULL_HANDLE ) return false;
+			size_t size = 0;
+			if (vkGetPipelineCacheData(m_device, m_cache, &size, nullptr) != VK_SUCCESS || size <= m_savedSize) return false;
+			std::vector<char> data(size);
+			if (vkGetPipelineCacheData(m_device, m_cache, &size, data.data()) != VK_SUCCESS) return false;
+			data.resize(size);
+
+			std::string tmp = m_path + ".tmp";
+			{
+				std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+				file.write(data.data(), data.size());
+				file.close();
+				if( !file ) return false;
+			}
+			std::error_code error;
+			std::filesystem::rename(tmp, m_path, error);
+			if( error ) {
+				std::filesystem::remove(tmp, error);
+				return false;
+			}
+			m_savedSize = size;
+			return true;
+		}
+
+		/// @brief Call once per frame, saves at most every interval seconds so pipelines created at runtime survive a crash.
+		void Update(double interval = 30.0) {
+			auto now = std::chrono::steady_clock::now();
+			if( std::chrono::duration<double>(now - m_lastSave).count() < interval ) return;
+			m_lastSave = now;
+			Save();
+		}
+
+	private:
+		/// Read the blob and check its header against this device, an empty result means no usable cache.
+		auto Load() -> std::vector<char> {
+			std::ifstream file(m_path, std::ios::ate | std::ios::binary);
+			if( !file.is_open() ) return {};
+			size_t size = (size_t)file.tellg();
+			if( size < sizeof(VkPipelineCacheHeaderVersionOne) ) return {};
+			std::vector<char> data(size);
+			file.seekg(0);
+			if( !file.read(data.data(), size) ) return {};
+
+			VkPipelineCacheHeaderVersionOne header;
+			memcpy(&header, data.data(), sizeof(header));
+			if( header.headerSize < sizeof(header) || header.headerSize > size
+				|| header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+				|| header.vendorID != m_properties.vendorID
+				|| header.deviceID != m_properties.deviceID
+				|| memcmp(header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) != 0 ) {
+				return {};
+			}
+			return data;
+		}
+
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		VkPipelineCache 		m_cache{VK_NULL_HANDLE};
+		VkPhysicalDeviceProperties m_properties{};
+		std::string 			m_path;
+		size_t 					m_savedSize{0};
+		std::chrono::steady_clock::time_point m_lastSave;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+	};
+
+} // namespace vvh
+
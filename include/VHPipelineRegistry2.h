@@ -0,0 +1,228 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <iostream>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+
+	/// @brief One binding per attribute present in format, in the order P N U C T, as VertexData stores them.
+	inline auto RenVertexBindings(uint32_t format) -> std::vector<VkVertexInputBindingDescription> {
+		static const uint32_t sizes[] = { VertexData::size_pos, VertexData::size_nor, VertexData::size_tex, VertexData::size_col, VertexData::size_tan };
+		std::vector<VkVertexInputBindingDescription> bindings;
+		for( uint32_t bit = 0; bit < 5; ++bit ) {
+			if( format & (1u << bit) ) bindings.push_back({ (uint32_t)bindings.size(), sizes[bit], VK_VERTEX_INPUT_RATE_VERTEX });
+		}
+		return bindings;
+	}
+
+	/// @brief Attribute locations are numbered like the bindings of RenVertexBindings().
+	inline auto RenVertexAttributes(uint32_t format) -> std::vector<VkVertexInputAttributeDescription> {
+		static const VkFormat formats[] = { VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32_SFLOAT,
+											VK_FORMAT_R32G32B32A32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT };
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		for( uint32_t bit = 0; bit < 5; ++bit ) {
+			if( format & (1u << bit) ) {
+				uint32_t location = (uint32_t)attributes.size();
+				attributes.push_back({ location, location, formats[bit], 0 });
+			}
+		}
+		return attributes;
+	}
+
+	//---------------------------------------------------------------------------------------------
+	// Maps pipeline permutations to pipelines and creates each one the first time it is asked for. A program
+	// holds what all its permutations share (shaders, descriptor set layouts, push constants), a PipelineKey
+	// selects the permutation. The table uses open addressing with linear probing over a flat array, so a
+	// lookup is one hash of a small key and usually one cache line. Not thread safe.
+
+	enum class BlendMode : uint8_t { Opaque, Alpha, Additive };
+
+	struct PipelineKey {
+		static constexpr uint32_t c_maxSpecialization = 8;
+
+		uint32_t 	m_program{0};		//from PipelineRegistry::AddProgram
+		uint32_t 	m_vertexFormat{0};	//VertexFormatBits, e.g. VertexData::getTypeMask()
+		VkRenderPass m_renderPass{VK_NULL_HANDLE};	//fixes the attachment formats
+		uint32_t 	m_specializationCount{0};
+		std::array<int32_t, c_maxSpecialization> m_specialization{};
+		BlendMode 	m_blend{BlendMode::Opaque};
+		bool 		m_depthTest{true};
+		bool 		m_depthWrite{true};
+		bool 		m_cullBack{true};
+		VkPipelineCreateFlags m_flags{0};	//e.g. VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT if the program's layouts are for a DescriptorBuffer
+
+		bool operator==(const PipelineKey& other) const {
+			return m_program == other.m_program && m_vertexFormat == other.m_vertexFormat && m_renderPass == other.m_renderPass
+				&& m_specializationCount == other.m_specializationCount && m_blend == other.m_blend
+				&& m_depthTest == other.m_depthTest && m_depthWrite == other.m_depthWrite && m_cullBack == other.m_cullBack
+				&& m_flags == other.m_flags
+				&& std::equal(m_specialization.begin(), m_specialization.begin() + m_specializationCount, other.m_specialization.begin());
+		}
+
+		auto Hash() const -> uint64_t {
+			uint64_t hash = 14695981039346656037ull;	//FNV-1a over 32 bit words
+			auto mix = [&](uint64_t value) { hash ^= value; hash *= 1099511628211ull; };
+			mix(m_program); mix(m_vertexFormat); mix((uint64_t)m_renderPass); mix(m_specializationCount);
+			for( uint32_t i = 0; i < m_specializationCount; ++i ) mix((uint32_t)m_specialization[i]);
+			mix((uint32_t)m_blend | (uint32_t)m_depthTest << 8 | (uint32_t)m_depthWrite << 9 | (uint32_t)m_cullBack << 10);
+			mix(m_flags);
+			return hash ^ (hash >> 32);
+		}
+	};
+
+	struct PipelineProgram {
+		std::string m_vertShaderPath;
+		std::string m_fragShaderPath;
+		std::vector<VkDescriptorSetLayout> 	m_descriptorSetLayouts;
+		std::vector<VkPushConstantRange> 	m_pushConstantRanges;
+		VkPipelineLayout 	m_pipelineLayout{VK_NULL_HANDLE};	//shared by all permutations if set, e.g. from a LayoutCache
+	};
+
+	class PipelineRegistry {
+	public:
+		struct Statistics {
+			uint64_t m_hits{0};
+			uint64_t m_misses{0};		//each miss created a pipeline
+		};
+
+		void Init(VkDevice device, ShaderLibrary& library, VkPipelineCache pipelineCache = VK_NULL_HANDLE,
+					const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_device = device;
+			m_library = &library;
+			m_pipelineCache = pipelineCache;
+			m_pAllocator = pAllocator;
+			m_slots.assign(64, Slot{});
+		}
+
+		void Destroy() {
+			for( auto& pipeline : m_pipelines ) {
+				vkDestroyPipeline(m_device, pipeline.m_pipeline, m_pAllocator);
+				bool shared = std::any_of(m_programs.begin(), m_programs.end(), [&](auto& p) { return p.m_pipelineLayout == pipeline.m_pipelineLayout; });
+				if( !shared ) vkDestroyPipelineLayout(m_device, pipeline.m_pipelineLayout, m_pAllocator);
+			}
+			m_pipelines.clear();
+			m_programs.clear();
+			m_slots.clear();
+		}
+
+		auto AddProgram(PipelineProgram program) -> uint32_t {
+			m_programs.push_back(std::move(program));
+			return (uint32_t)m_programs.size() - 1;
+		}
+
+		/// @brief The pipeline for key, created on the first call with this key. Throws if the key is invalid.
+		auto Get(const PipelineKey& key) -> Pipeline {
+			//checked before hashing and comparing, both read m_specializationCount entries
+			if( key.m_program >= m_programs.size() || key.m_specializationCount > PipelineKey::c_maxSpecialization ) {
+				throw std::runtime_error("failed to create pipeline, invalid pipeline key!");
+			}
+			uint64_t hash = key.Hash();
+			size_t mask = m_slots.size() - 1;
+			for( size_t i = hash & mask; ; i = (i + 1) & mask ) {
+				Slot& slot = m_slots[i];
+				if( slot.m_index < 0 ) break;
+				if( slot.m_hash == hash && slot.m_key == key ) {
+					++m_statistics.m_hits;
+					return m_pipelines[slot.m_index];
+				}
+			}
+			++m_statistics.m_misses;
+			m_pipelines.push_back(Create(key));
+			Insert(key, hash, (int32_t)m_pipelines.size() - 1);
+			return m_pipelines.back();
+		}
+
+		auto GetStatistics() const -> const Statistics& { return m_statistics; }
+		auto Size() const -> size_t { return m_pipelines.size(); }
+
+		void PrintStatistics(std::ostream& out = std::cout) const {
+			out << "Pipeline registry: " << m_statistics.m_misses << " pipelines created, " << m_statistics.m_hits << " hits\n";
+		}
+
+	private:
+		struct Slot {
+			PipelineKey m_key;
+			uint64_t 	m_hash{0};
+			int32_t 	m_index{-1};	//into m_pipelines, -1 if empty
+		};
+
+		void Insert(const PipelineKey& key, uint64_t hash, int32_t index) {
+			if( 2 * (m_pipelines.size() + 1) > m_slots.size() ) {	//keep the load factor at most 1/2
+				std::vector<Slot> old(2 * m_slots.size());
+				old.swap(m_slots);
+				for( auto& slot : old ) if( slot.m_index >= 0 ) Place(slot);
+			}
+			Place({ key, hash, index });
+		}
+
+		void Place(const Slot& slot) {
+			size_t mask = m_slots.size() - 1;
+			size_t i = slot.m_hash & mask;
+			while( m_slots[i].m_index >= 0 ) i = (i + 1) & mask;
+			m_slots[i] = slot;
+		}
+
+		/// The key has been validated by Get().
+		auto Create(const PipelineKey& key) -> Pipeline {
+			auto& program = m_programs[key.m_program];
+
+			VkPipelineColorBlendAttachmentState blend{};
+			blend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+			if( key.m_blend != BlendMode::Opaque ) {
+				blend.blendEnable = VK_TRUE;
+				blend.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+				blend.dstColorBlendFactor = key.m_blend == BlendMode::Alpha ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+				blend.colorBlendOp = VK_BLEND_OP_ADD;
+				blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+				blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+				blend.alphaBlendOp = VK_BLEND_OP_ADD;
+			}
+			std::vector<VkPipelineColorBlendAttachmentState> blendAttachments{ blend };
+			std::vector<int32_t> specialization(key.m_specialization.begin(), key.m_specialization.begin() + key.m_specializationCount);
+			VkBool32 depthTest = key.m_depthTest, depthWrite = key.m_depthWrite;
+			VkCullModeFlags cullMode = key.m_cullBack ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
+
+			Pipeline pipeline{};
+			RenCreateGraphicsPipeline({
+				.m_device 					= m_device,
+				.m_renderPass 				= key.m_renderPass,
+				.m_vertShaderPath 			= program.m_vertShaderPath,
+				.m_fragShaderPath 			= program.m_fragShaderPath,
+				.m_bindingDescription 		= RenVertexBindings(key.m_vertexFormat),
+				.m_attributeDescriptions 	= RenVertexAttributes(key.m_vertexFormat),
+				.m_descriptorSetLayouts 	= program.m_descriptorSetLayouts,
+				.m_specializationConstants 	= specialization,
+				.m_pushConstantRanges 		= program.m_pushConstantRanges,
+				.m_blendAttachments 		= blendAttachments,
+				.m_graphicsPipeline 		= pipeline,
+				.m_pAllocator 				= m_pAllocator,
+				.m_pipelineCache 			= m_pipelineCache,
+				.m_vertShaderModule 		= m_library->Load(program.m_vertShaderPath),
+				.m_fragShaderModule 		= program.m_fragShaderPath.empty() ? VK_NULL_HANDLE : m_library->Load(program.m_fragShaderPath),
+				.m_depthTest 				= depthTest,
+				.m_depthWrite 				= depthWrite,
+				.m_cullMode 				= cullMode,
+				.m_pipelineLayout 			= program.m_pipelineLayout,
+				.m_flags 					= key.m_flags
+			});
+			return pipeline;
+		}
+
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		ShaderLibrary* 			m_library{nullptr};
+		VkPipelineCache 		m_pipelineCache{VK_NULL_HANDLE};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		std::vector<PipelineProgram> m_programs;
+		std::vector<Pipeline> 	m_pipelines;
+		std::vector<Slot> 		m_slots;		//power of two size
+		Statistics 				m_statistics;
+	};
+
+} // namespace vvh
+
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// GPU profiler based on timestamp queries. Every frame in flight has its own query pool. The results of a
+	// frame are read when its slot is used again, i.e. MAX_FRAMES_IN_FLIGHT frames later after its fence has
+	// been waited for, so reading never stalls. Without timestamp support on the queue all calls do nothing.
+	// Not thread safe, record all scopes of a frame from one thread.
+
+	class GpuProfiler {
+	public:
+		struct Scope {
+			std::string m_name;
+			uint32_t 	m_depth{0};		//nesting level, 0 for top level scopes
+			double 		m_ms{0};
+			double 		m_averageMs{0};	//exponential moving average over frames
+		};
+
+		/// @brief synchronization2 selects vkCmdWriteTimestamp2 and must only be set if the feature is enabled on the device.
+		void Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, bool synchronization2 = false,
+					uint32_t maxScopes = 64, uint32_t frames = MAX_FRAMES_IN_FLIGHT, const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_device = device;
+			m_pAllocator = pAllocator;
+			m_maxScopes = maxScopes;
+
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+			uint32_t count = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, nullptr);
+			std::vector<VkQueueFamilyProperties> families(count);
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, families.data());
+
+			//timestampComputeAndGraphics guarantees support on all graphics and compute queues, otherwise the queue decides
+			uint32_t validBits = queueFamily < count ? families[queueFamily].timestampValidBits : 0;
+			m_enabled = validBits > 0 && properties.limits.timestampPeriod > 0.0f;
+			if( !m_enabled ) return;
+
+			m_timestampPeriod = properties.limits.timestampPeriod;
+			m_mask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+			m_synchronization2 = synchronization2 && (vkCmdWriteTimestamp2 != nullptr || vkCmdWriteTimestamp2KHR != nullptr);
+
+			VkQueryPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			poolInfo.queryCount = 2 * maxScopes;
+
+			m_frames.resize(frames);
+			for( auto& frame : m_frames ) {
+				if (vkCreateQueryPool(m_device, &poolInfo, m_pAllocator, &frame.m_pool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create timestamp query pool!");
+				}
+			}
+			m_timestamps.resize(2 * maxScopes);
+		}
+
+		void Destroy() {
+			for( auto& frame : m_frames ) vkDestroyQueryPool(m_device, frame.m_pool, m_pAllocator);
+			m_frames.clear();
+			m_results.clear();
+			m_enabled = false;
+		}
+
+		/// @brief Call right after beginning the frame's command buffer, outside of a render pass. Collects the results
+		/// of the last frame that used this slot and resets its queries. frame is the index of the frame in flight.
+		void BeginFrame(VkCommandBuffer commandBuffer, uint32_t frame) {
+			if( !m_enabled ) return;
+			m_current = &m_frames[frame % m_frames.size()];
+			Collect(*m_current);
+			m_current->m_names.clear();
+			m_current->m_depths.clear();
+			m_current->m_ended.clear();
+			m_depth = 0;
+			vkCmdResetQueryPool(commandBuffer, m_current->m_pool, 0, 2 * m_maxScopes);
+		}
+
+		/// @brief Write the start timestamp of a scope. Returns the scope index for End(), or UINT32_MAX if the scope is not recorded.
+		auto Begin(VkCommandBuffer commandBuffer, const std::string& name) -> uint32_t {
+			if( !m_enabled || m_current == nullptr || m_current->m_names.size() >= m_maxScopes ) return UINT32_MAX;
+			uint32_t index = (uint32_t)m_current->m_names.size();
+			m_current->m_names.push_back(name);
+			m_current->m_depths.push_back(m_depth++);
+			m_current->m_ended.push_back(false);
+			WriteTimestamp(commandBuffer, 2 * index, true);
+			return index;
+		}
+
+		void End(VkCommandBuffer commandBuffer, uint32_t index) {
+			if( index == UINT32_MAX || m_current == nullptr || index >= m_current->m_ended.size() ) return;
+			WriteTimestamp(commandBuffer, 2 * index + 1, false);
+			m_current->m_ended[index] = true;
+			--m_depth;
+		}
+
+		/// @brief Scopes of the last frame whose results were available, in the order they were begun.
+		auto Results() const -> const std::vector<Scope>& { return m_results; }
+
+		/// @brief Time of the named scope in the last available frame, 0 if it was not recorded.
+		auto Find(const std::string& name) const -> double {
+			for( auto& scope : m_results ) if( scope.m_name == name ) return scope.m_ms;
+			return 0.0;
+		}
+
+		auto Enabled() const -> bool { return m_enabled; }
+
+	#ifdef IMGUI_VERSION
+		void DrawImGui(const char* title = "GPU Profiler") {
+			ImGui::Begin(title);
+			if( !m_enabled ) {
+				ImGui::Text("Timestamps are not supported on this queue.");
+			} else if( ImGui::BeginTable("scopes", 3) ) {
+				ImGui::TableSetupColumn("Scope");
+				ImGui::TableSetupColumn("ms");
+				ImGui::TableSetupColumn("avg ms");
+				ImGui::TableHeadersRow();
+				for( auto& scope : m_results ) {
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::Text("%*s%s", 2 * (int)scope.m_depth, "", scope.m_name.c_str());
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", scope.m_ms);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", scope.m_averageMs);
+				}
+				ImGui::EndTable();
+			}
+			ImGui::End();
+		}
+	#endif
+
+	private:
+		struct Frame {
+			VkQueryPool 				m_pool{VK_NULL_HANDLE};
+			std::vector<std::string> 	m_names;
+			std::vector<uint32_t> 		m_depths;
+			std::vector<bool> 			m_ended;
+		};
+
+		void WriteTimestamp(VkCommandBuffer commandBuffer, uint32_t query, bool begin) {
+			if( m_synchronization2 ) {
+				VkPipelineStageFlags2 stage = begin ? VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+				auto write = vkCmdWriteTimestamp2 != nullptr ? vkCmdWriteTimestamp2 : vkCmdWriteTimestamp2KHR;
+				write(commandBuffer, stage, m_current->m_pool, query);
+			} else {
+				VkPipelineStageFlagBits stage = begin ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+				vkCmdWriteTimestamp(commandBuffer, stage, m_current->m_pool, query);
+			}
+		}
+
+		/// Read the timestamps of a frame without waiting. Keeps the previous results if they are not available yet.
+		void Collect(const Frame& frame) {
+			uint32_t scopes = (uint32_t)frame.m_names.size();
+			if( scopes == 0 ) return;
+			VkResult result = vkGetQueryPoolResults(m_device, frame.m_pool, 0, 2 * scopes, 2 * scopes * sizeof(uint64_t),
+				m_timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+			if( result != VK_SUCCESS ) return;
+
+			m_results.clear();
+			for( uint32_t i = 0; i < scopes; ++i ) {
+				if( !frame.m_ended[i] ) continue;
+				uint64_t ticks = (m_timestamps[2 * i + 1] - m_timestamps[2 * i]) & m_mask;
+				double ms = ticks * (double)m_timestampPeriod / 1e6;
+				double& average = m_average[frame.m_names[i]];
+				average = average == 0.0 ? ms : 0.95 * average + 0.05 * ms;
+				m_results.push_back({ frame.m_names[i], frame.m_depths[i], ms, average });
+			}
+		}
+
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		bool 					m_enabled{false};
+		bool 					m_synchronization2{false};
+		float 					m_timestampPeriod{1.0f};	//nanoseconds per tick
+		uint64_t 				m_mask{~0ull};				//valid bits of a timestamp
+		uint32_t 				m_maxScopes{0};
+		uint32_t 				m_depth{0};
+		std::vector<Frame> 		m_frames;
+		Frame* 					m_current{nullptr};
+		std::vector<uint64_t> 	m_timestamps;
+		std::vector<Scope> 		m_results;
+		std::unordered_map<std::string, double> m_average;
+	};
+
+	/// Begins a GPU profiler scope on construction and ends it on destruction.
+	class GpuScope {
+	public:
+		GpuScope(GpuProfiler& profiler, VkCommandBuffer commandBuffer, const std::string& name)
+			: m_profiler{profiler}, m_commandBuffer{commandBuffer}, m_index{profiler.Begin(commandBuffer, name)} {}
+		~GpuScope() { m_profiler.End(m_commandBuffer, m_index); }
+
+		GpuScope(const GpuScope&) = delete;
+		GpuScope& operator=(const GpuScope&) = delete;
+
+	private:
+		GpuProfiler& 	m_profiler;
+		VkCommandBuffer m_commandBuffer;
+		uint32_t 		m_index;
+	};
+
+} // namespace vvh
+
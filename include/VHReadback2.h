@@ -0,0 +1,188 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <algorithm>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Asynchronous image readback. The copy is recorded into the frame's command buffer and lands in
+	// one of a ring of persistently mapped, host cached buffers. Each copy is tagged with the number of the
+	// frame it is submitted in, and Poll() hands the data to the caller once the caller reports that frame
+	// as completed, i.e. after waiting for its fence, so the CPU never waits for the GPU. The status of the
+	// frame fence itself is not used: until the frame is submitted it still shows an older signal.
+	// Not thread safe, use it from the thread that records and submits the frame.
+
+	class ReadbackQueue {
+	public:
+		/// Called from Poll() with the tightly packed image data. The pointer is only valid during the call.
+		using Callback = std::function<void(const uint8_t* data, uint32_t width, uint32_t height, VkDeviceSize size)>;
+
+		struct Statistics {
+			uint64_t m_recorded{0};
+			uint64_t m_completed{0};
+			uint64_t m_dropped{0};		//the ring was full
+		};
+
+		/// @brief slots should be at least MAX_FRAMES_IN_FLIGHT + 1 to read back every frame.
+		void Init(VkDevice device, VmaAllocator vmaAllocator, uint32_t slots = MAX_FRAMES_IN_FLIGHT + 1) {
+			m_device = device;
+			m_vmaAllocator = vmaAllocator;
+			m_slots.resize(slots);
+		}
+
+		/// @brief Free all buffers. Pending readbacks are dropped, call after vkDeviceWaitIdle().
+		void Destroy() {
+			for( auto& slot : m_slots ) {
+				if( slot.m_buffer != VK_NULL_HANDLE ) vmaDestroyBuffer(m_vmaAllocator, slot.m_buffer, slot.m_allocation);
+			}
+			m_slots.clear();
+			m_head = m_tail = m_pending = 0;
+			m_completedFrames = 0;
+		}
+
+		/// @brief Record a copy of the image into commandBuffer, outside of a render pass. The image must be in
+		/// layout and is returned to it. frameNumber is the frame the command buffer is submitted in, frame numbers
+		/// must not decrease. Returns false if all slots are in flight, the frame is then skipped.
+		bool Record(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout, uint32_t width, uint32_t height,
+					uint64_t frameNumber, Callback callback, uint32_t bytesPerPixel = 4, VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT) {
+
+			if( m_pending == m_slots.size() ) Poll();
+			if( m_pending == m_slots.size() ) { ++m_statistics.m_dropped; return false; }
+
+			Slot& slot = m_slots[m_tail];
+			VkDeviceSize size = (VkDeviceSize)width * height * bytesPerPixel;
+			if( slot.m_capacity < size ) {
+				if( slot.m_buffer != VK_NULL_HANDLE ) vmaDestroyBuffer(m_vmaAllocator, slot.m_buffer, slot.m_allocation);
+				VmaAllocationInfo allocInfo;
+				BufCreateBuffer( {
+					.m_vmaAllocator 	= m_vmaAllocator,
+					.m_size 			= size,
+					.m_usageFlags 		= VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					.m_properties 		= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+					.m_vmaFlags 		= VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+					.m_buffer 			= slot.m_buffer,
+					.m_allocation 		= slot.m_allocation,
+					.m_allocationInfo 	= &allocInfo
+				});
+				slot.m_mapped = (const uint8_t*)allocInfo.pMappedData;
+				slot.m_capacity = size;
+			}
+
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = layout;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange = { aspect, 0, 1, 0, 1 };
+			barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkBufferImageCopy region{};
+			region.imageSubresource = { aspect, 0, 0, 1 };
+			region.imageExtent = { width, height, 1 };
+			vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.m_buffer, 1, &region);
+
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = layout;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = 0;
+
+			VkBufferMemoryBarrier bufferBarrier{};
+			bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.buffer = slot.m_buffer;
+			bufferBarrier.size = size;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0,
+				0, nullptr, 1, &bufferBarrier, 1, &barrier);
+
+			slot.m_frame = frameNumber;
+			slot.m_width = width;
+			slot.m_height = height;
+			slot.m_size = size;
+			slot.m_callback = std::move(callback);
+			m_tail = (m_tail + 1) % (uint32_t)m_slots.size();
+			++m_pending;
+			++m_statistics.m_recorded;
+			return true;
+		}
+
+		/// @brief Like Record(), but the 8 bit, 4 channel image is swizzled into a vector that is returned through a future.
+		/// If the ring is full, the future holds an exception.
+		auto Record(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout, uint32_t width, uint32_t height,
+					uint64_t frameNumber, const SwizzlePattern& pattern = {}) -> std::future<std::vector<uint8_t>> {
+
+			auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+			auto future = promise->get_future();
+			bool recorded = Record(commandBuffer, image, layout, width, height, frameNumber,
+				[promise, pattern](const uint8_t* data, uint32_t w, uint32_t h, VkDeviceSize) {
+					std::vector<uint8_t> pixels((size_t)w * h * pattern.m_channels);
+					SwzSwizzle(data, pixels.data(), (size_t)w * h, pattern);
+					promise->set_value(std::move(pixels));
+				});
+			if( !recorded ) promise->set_exception(std::make_exception_ptr(std::runtime_error("readback queue is full!")));
+			return future;
+		}
+
+		/// @brief Deliver the readbacks of all frames before completedFrames, oldest first. Call once per frame after
+		/// waiting for a frame's fence, with the number of that frame + 1. Returns the number of delivered readbacks.
+		auto Poll(uint64_t completedFrames) -> uint32_t {
+			m_completedFrames = std::max(m_completedFrames, completedFrames);
+			return Poll();
+		}
+
+		/// @brief Deliver with the frames reported as completed so far.
+		auto Poll() -> uint32_t {
+			uint32_t delivered = 0;
+			while( m_pending > 0 ) {
+				Slot& slot = m_slots[m_head];
+				if( slot.m_frame >= m_completedFrames ) break;	//later slots were submitted later
+				vmaInvalidateAllocation(m_vmaAllocator, slot.m_allocation, 0, slot.m_size);
+				if( slot.m_callback ) slot.m_callback(slot.m_mapped, slot.m_width, slot.m_height, slot.m_size);
+				slot.m_callback = nullptr;
+				m_head = (m_head + 1) % (uint32_t)m_slots.size();
+				--m_pending;
+				++m_statistics.m_completed;
+				++delivered;
+			}
+			return delivered;
+		}
+
+		auto Pending() const -> uint32_t { return m_pending; }
+		auto GetStatistics() const -> const Statistics& { return m_statistics; }
+
+	private:
+		struct Slot {
+			VkBuffer 		m_buffer{VK_NULL_HANDLE};
+			VmaAllocation 	m_allocation{nullptr};
+			const uint8_t* 	m_mapped{nullptr};
+			VkDeviceSize 	m_capacity{0};
+			VkDeviceSize 	m_size{0};
+			uint64_t 		m_frame{0};			//frame number the copy is submitted in
+			uint32_t 		m_width{0};
+			uint32_t 		m_height{0};
+			Callback 		m_callback;
+		};
+
+		VkDevice 			m_device{VK_NULL_HANDLE};
+		VmaAllocator 		m_vmaAllocator{nullptr};
+		std::vector<Slot> 	m_slots;
+		uint32_t 			m_head{0};		//oldest pending slot
+		uint32_t 			m_tail{0};		//next free slot
+		uint32_t 			m_pending{0};
+		uint64_t 			m_completedFrames{0};	//frames before this one have finished on the GPU
+		Statistics 			m_statistics;
+	};
+
+} // namespace vvh
+
@@ -11,10 +11,12 @@ namespace vvh {
 		const SwapChain& 	m_swapChain;
 		const bool& 		m_clear;
 		VkRenderPass& 		m_renderPass;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = RenCreateRenderPassInfo>
 	inline void RenCreateRenderPass(T&& info) {
+        VVH_ZONE_FUNCTION;
         VkAttachmentDescription colorAttachment{};
         colorAttachment.format = info.m_swapChain.m_swapChainImageFormat;
         colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;      
@@ -78,7 +80,7 @@ namespace vvh {
         renderPassInfo.dependencyCount = dependencies.size();
         renderPassInfo.pDependencies = dependencies.data();
 
-        if (vkCreateRenderPass(info.m_device, &renderPassInfo, nullptr, &info.m_renderPass) != VK_SUCCESS) {
+        if (vkCreateRenderPass(info.m_device, &renderPassInfo, info.m_pAllocator, &info.m_renderPass) != VK_SUCCESS) {
             throw std::runtime_error("failed to create render pass!");
         }
     }
@@ -89,13 +91,19 @@ namespace vvh {
 		const VkDevice& 									m_device;
 		const std::vector<VkDescriptorSetLayoutBinding>& 	m_bindings;
 		VkDescriptorSetLayout& 								m_descriptorSetLayout;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		const bool m_keepBindings{false};	//use the binding numbers and counts as given, e.g. from reflection
+		const bool m_pushDescriptor{false};	//written with ComPushDescriptors instead of allocated, needs VK_KHR_push_descriptor
+		const bool m_descriptorBuffer{false};	//lives in a DescriptorBuffer instead of a pool, needs VK_EXT_descriptor_buffer
 	};
 
 	template<typename T = RenCreateDescriptorSetLayoutInfo>
 	inline void RenCreateDescriptorSetLayout(T&& info) {
+		VVH_ZONE_FUNCTION;
 		uint32_t i = 0;
 		std::vector<VkDescriptorSetLayoutBinding> bindings = info.m_bindings;
 		for( auto& uboLayoutBinding : bindings ) {
+			if( info.m_keepBindings ) break;
 	        uboLayoutBinding.binding = i;
 	        uboLayoutBinding.descriptorCount = 1;
 	        uboLayoutBinding.pImmutableSamplers = nullptr;
@@ -104,10 +112,12 @@ namespace vvh {
 
         VkDescriptorSetLayoutCreateInfo layoutInfo{};
         layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.flags = info.m_pushDescriptor ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
+        if( info.m_descriptorBuffer ) layoutInfo.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
         layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
         layoutInfo.pBindings = bindings.data();
 
-        if (vkCreateDescriptorSetLayout(info.m_device, &layoutInfo, nullptr, &info.m_descriptorSetLayout) != VK_SUCCESS) {
+        if (vkCreateDescriptorSetLayout(info.m_device, &layoutInfo, info.m_pAllocator, &info.m_descriptorSetLayout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create descriptor set layout 0!");
         }
     }
@@ -118,10 +128,12 @@ namespace vvh {
 		const VkDevice& 	m_device;
 		const uint32_t& 	m_sizes;
 		VkDescriptorPool& 	m_descriptorPool;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = RenCreateDescriptorPoolInfo>
 	inline void RenCreateDescriptorPool(T&& info) {
+		VVH_ZONE_FUNCTION;
 
 		std::vector<VkDescriptorPoolSize> pool_sizes;
 		pool_sizes.push_back({ VK_DESCRIPTOR_TYPE_SAMPLER, info.m_sizes });
@@ -143,7 +155,7 @@ namespace vvh {
         pool_info.poolSizeCount = (uint32_t)std::size(pool_sizes);
         pool_info.pPoolSizes = pool_sizes.data();
 
-		if (vkCreateDescriptorPool(info.m_device, &pool_info, nullptr, &info.m_descriptorPool) != VK_SUCCESS) {
+		if (vkCreateDescriptorPool(info.m_device, &pool_info, info.m_pAllocator, &info.m_descriptorPool) != VK_SUCCESS) {
             throw std::runtime_error("failed to create descriptor pool!");
         }
     }
@@ -159,6 +171,7 @@ namespace vvh {
 
 	template<typename T = RenCreateDescriptorSetInfo>
 	inline void RenCreateDescriptorSet(T&& info) {
+		VVH_ZONE_FUNCTION;
 
 		info.m_descriptorSet.m_descriptorSetPerFrameInFlight.resize(MAX_FRAMES_IN_FLIGHT);
         std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, info.m_descriptorSetLayouts);
@@ -184,26 +197,26 @@ namespace vvh {
 
 	template<typename T = RenUpdateDescriptorSetInfo>
 	inline void RenUpdateDescriptorSet(T&& info) {
-
-		size_t i = 0;
-		for ( auto& ds : info.m_descriptorSet.m_descriptorSetPerFrameInFlight ) {
-			VkDescriptorBufferInfo bufferInfo{};
-			bufferInfo.buffer = info.m_uniformBuffers.m_uniformBuffers[i++];
-			bufferInfo.offset = 0;
-			bufferInfo.range = info.m_size;
-
-			VkWriteDescriptorSet descriptorWrites{};
-
-			descriptorWrites.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites.dstSet = ds;
-			descriptorWrites.dstBinding = (uint32_t)info.m_binding;
-			descriptorWrites.dstArrayElement = 0;
-			descriptorWrites.descriptorType = info.m_type;
-			descriptorWrites.descriptorCount = 1;
-			descriptorWrites.pBufferInfo = &bufferInfo;
-
-			vkUpdateDescriptorSets(info.m_device, 1, &descriptorWrites, 0, nullptr);
+		VVH_ZONE_FUNCTION;
+
+		//one call for the sets of all frames in flight, the infos are sized first so the pointers stay valid
+		auto& sets = info.m_descriptorSet.m_descriptorSetPerFrameInFlight;
+		std::vector<VkDescriptorBufferInfo> bufferInfos(sets.size());
+		std::vector<VkWriteDescriptorSet> descriptorWrites(sets.size());
+		for ( size_t i = 0; i < sets.size(); ++i ) {
+			bufferInfos[i].buffer = info.m_uniformBuffers.m_uniformBuffers[i];
+			bufferInfos[i].offset = 0;
+			bufferInfos[i].range = info.m_size;
+
+			descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[i].dstSet = sets[i];
+			descriptorWrites[i].dstBinding = (uint32_t)info.m_binding;
+			descriptorWrites[i].dstArrayElement = 0;
+			descriptorWrites[i].descriptorType = info.m_type;
+			descriptorWrites[i].descriptorCount = 1;
+			descriptorWrites[i].pBufferInfo = &bufferInfos[i];
 		}
+		vkUpdateDescriptorSets(info.m_device, (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
 	}
 
 	//---------------------------------------------------------------------------------------------
@@ -217,45 +230,45 @@ namespace vvh {
 
 	template<typename T = RenUpdateDescriptorSetTextureInfo>
 	inline void RenUpdateDescriptorSetTexture(T&& info) {
-
-		size_t i = 0;
-	    for ( auto& ds : info.m_descriptorSet.m_descriptorSetPerFrameInFlight ) {
-
-	        VkDescriptorImageInfo imageInfo{};
-	        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	        imageInfo.imageView = info.m_texture.m_mapImageView;
-	        imageInfo.sampler = info.m_texture.m_mapSampler;
-
-	        VkWriteDescriptorSet descriptorWrites{};
-
-	        descriptorWrites.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	        descriptorWrites.dstSet = ds;
-	        descriptorWrites.dstBinding = info.m_binding;
-	        descriptorWrites.dstArrayElement = 0;
-	        descriptorWrites.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	        descriptorWrites.descriptorCount = 1;
-	        descriptorWrites.pImageInfo = &imageInfo;
-
-	        vkUpdateDescriptorSets(info.m_device, 1, &descriptorWrites, 0, nullptr);
-		}
+		VVH_ZONE_FUNCTION;
+
+	    auto& sets = info.m_descriptorSet.m_descriptorSetPerFrameInFlight;
+	    VkDescriptorImageInfo imageInfo{};
+	    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	    imageInfo.imageView = info.m_texture.m_mapImageView;
+	    imageInfo.sampler = info.m_texture.m_mapSampler;
+
+	    std::vector<VkWriteDescriptorSet> descriptorWrites(sets.size());
+	    for ( size_t i = 0; i < sets.size(); ++i ) {
+	        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	        descriptorWrites[i].dstSet = sets[i];
+	        descriptorWrites[i].dstBinding = (uint32_t)info.m_binding;
+	        descriptorWrites[i].dstArrayElement = 0;
+	        descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	        descriptorWrites[i].descriptorCount = 1;
+	        descriptorWrites[i].pImageInfo = &imageInfo;
+	    }
+	    vkUpdateDescriptorSets(info.m_device, (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
     }
 
 	//---------------------------------------------------------------------------------------------
 
     struct RenCreateShaderModuleInfo {
 		const VkDevice& 			m_device;
-		const std::vector<char>& 	m_code;
+		const std::span<const char> m_code;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = RenCreateShaderModuleInfo>
 	inline auto RenCreateShaderModule(T&& info) -> VkShaderModule {
+        VVH_ZONE_FUNCTION;
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
         createInfo.codeSize = info.m_code.size();
         createInfo.pCode = reinterpret_cast<const uint32_t*>(info.m_code.data());
 
         VkShaderModule shaderModule;
-        if (vkCreateShaderModule(info.m_device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        if (vkCreateShaderModule(info.m_device, &createInfo, info.m_pAllocator, &shaderModule) != VK_SUCCESS) {
             throw std::runtime_error("failed to create shader module!");
         }
         return shaderModule;
@@ -275,10 +288,20 @@ namespace vvh {
 		const std::vector<VkPushConstantRange>& 				m_pushConstantRanges;
 		const std::vector<VkPipelineColorBlendAttachmentState>& m_blendAttachments;
   		Pipeline& m_graphicsPipeline;
+  		const VkAllocationCallbacks* m_pAllocator{nullptr};
+  		const VkPipelineCache m_pipelineCache{VK_NULL_HANDLE};
+  		const VkShaderModule m_vertShaderModule{VK_NULL_HANDLE};	//used instead of the path if set, the caller keeps ownership
+  		const VkShaderModule m_fragShaderModule{VK_NULL_HANDLE};
+  		const VkBool32 m_depthTest{VK_TRUE};
+  		const VkBool32 m_depthWrite{VK_TRUE};
+  		const VkCullModeFlags m_cullMode{VK_CULL_MODE_BACK_BIT};
+  		const VkPipelineLayout m_pipelineLayout{VK_NULL_HANDLE};	//shared layout used instead of creating one, the caller keeps ownership
+  		const VkPipelineCreateFlags m_flags{0};	//e.g. VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
 	};
 
 	template<typename T = RenCreateGraphicsPipelineInfo>
 	inline void RenCreateGraphicsPipeline(T&& info) {
+	    VVH_ZONE_FUNCTION;
 
 	    // Specialization constant setup
 	    std::vector<VkSpecializationMapEntry> specializationEntries;
@@ -294,10 +317,14 @@ namespace vvh {
 	    specializationInfo.pData = info.m_specializationConstants.data();
 
 		std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+		bool hasFrag = !info.m_fragShaderPath.empty() || info.m_fragShaderModule != VK_NULL_HANDLE;
 
         VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-        auto vertShaderCode = vvh::ReadFile(info.m_vertShaderPath);
-        VkShaderModule vertShaderModule = RenCreateShaderModule({info.m_device, vertShaderCode });
+        VkShaderModule vertShaderModule = info.m_vertShaderModule;
+        if( vertShaderModule == VK_NULL_HANDLE ) {
+	        FileView vertShaderCode(info.m_vertShaderPath);
+	        vertShaderModule = RenCreateShaderModule({info.m_device, vertShaderCode.Span(), info.m_pAllocator });
+        }
         vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
         vertShaderStageInfo.module = vertShaderModule;
@@ -305,11 +332,13 @@ namespace vvh {
 		vertShaderStageInfo.pSpecializationInfo = &specializationInfo;
 		shaderStages.push_back(vertShaderStageInfo);
 
-		VkShaderModule fragShaderModule{};
-		if( !info.m_fragShaderPath.empty() ) {
+		VkShaderModule fragShaderModule = info.m_fragShaderModule;
+		if( hasFrag ) {
 	        VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-	        auto fragShaderCode = vvh::ReadFile(info.m_fragShaderPath);
-	        fragShaderModule = RenCreateShaderModule({info.m_device, fragShaderCode });
+	        if( fragShaderModule == VK_NULL_HANDLE ) {
+		        FileView fragShaderCode(info.m_fragShaderPath);
+		        fragShaderModule = RenCreateShaderModule({info.m_device, fragShaderCode.Span(), info.m_pAllocator });
+	        }
 	        fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	        fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	        fragShaderStageInfo.module = fragShaderModule;
@@ -321,7 +350,7 @@ namespace vvh {
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-		if( !info.m_fragShaderPath.empty() ) {
+		if( hasFrag ) {
 	        vertexInputInfo.vertexBindingDescriptionCount = (uint32_t)info.m_bindingDescription.size();
 	        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(info.m_attributeDescriptions.size());
 	        vertexInputInfo.pVertexBindingDescriptions = info.m_bindingDescription.data();
@@ -344,7 +373,7 @@ namespace vvh {
         rasterizer.rasterizerDiscardEnable = VK_FALSE;
         rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
         rasterizer.lineWidth = 1.0f;
-        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT; //VK_CULL_MODE_NONE
+        rasterizer.cullMode = info.m_cullMode;
         rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
         rasterizer.depthBiasEnable = VK_FALSE;
 
@@ -355,8 +384,8 @@ namespace vvh {
 
         VkPipelineDepthStencilStateCreateInfo depthStencil{};
         depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-        depthStencil.depthTestEnable = VK_TRUE;
-        depthStencil.depthWriteEnable = VK_TRUE;
+        depthStencil.depthTestEnable = info.m_depthTest;
+        depthStencil.depthWriteEnable = info.m_depthWrite;
         depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL ;
         depthStencil.depthBoundsTestEnable = VK_FALSE;
         depthStencil.stencilTestEnable = VK_FALSE;
@@ -397,12 +426,15 @@ namespace vvh {
         pipelineLayoutInfo.pushConstantRangeCount = info.m_pushConstantRanges.size();
         pipelineLayoutInfo.pPushConstantRanges = info.m_pushConstantRanges.size() > 0 ? info.m_pushConstantRanges.data() : nullptr;
 
-        if (vkCreatePipelineLayout(info.m_device, &pipelineLayoutInfo, nullptr, &info.m_graphicsPipeline.m_pipelineLayout) != VK_SUCCESS) {
+        info.m_graphicsPipeline.m_pipelineLayout = info.m_pipelineLayout;
+        if (info.m_pipelineLayout == VK_NULL_HANDLE && 
+            vkCreatePipelineLayout(info.m_device, &pipelineLayoutInfo, info.m_pAllocator, &info.m_graphicsPipeline.m_pipelineLayout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
         }
 
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.flags = info.m_flags;
         pipelineInfo.stageCount = (uint32_t)shaderStages.size();
         pipelineInfo.pStages = shaderStages.data();
         pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -418,12 +450,12 @@ namespace vvh {
         pipelineInfo.subpass = 0;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if (vkCreateGraphicsPipelines(info.m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &info.m_graphicsPipeline.m_pipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(info.m_device, info.m_pipelineCache, 1, &pipelineInfo, info.m_pAllocator, &info.m_graphicsPipeline.m_pipeline) != VK_SUCCESS) {
             throw std::runtime_error("failed to create graphics pipeline!");
         }
 
-		if(shaderStages.size() > 1) { vkDestroyShaderModule(info.m_device, fragShaderModule, nullptr); }
-        vkDestroyShaderModule(info.m_device, vertShaderModule, nullptr);
+		if(shaderStages.size() > 1 && info.m_fragShaderModule == VK_NULL_HANDLE) { vkDestroyShaderModule(info.m_device, fragShaderModule, info.m_pAllocator); }
+        if(info.m_vertShaderModule == VK_NULL_HANDLE) { vkDestroyShaderModule(info.m_device, vertShaderModule, info.m_pAllocator); }
     }
 
 	//---------------------------------------------------------------------------------------------
@@ -432,11 +464,13 @@ namespace vvh {
 		const VkDevice& 	m_device;
 		const DepthImage& 	m_depthImage;
 		const VkRenderPass& m_renderPass;
-		SwapChain& 			m_swapChain; 
+		SwapChain& 			m_swapChain;
+		const VkAllocationCallbacks* m_pAllocator{nullptr}; 
 	};
 
 	template<typename T = RenCreateFramebuffersInfo>
 	inline void RenCreateFramebuffers(T&& info) {
+        VVH_ZONE_FUNCTION;
         info.m_swapChain.m_swapChainFramebuffers.resize(info.m_swapChain.m_swapChainImageViews.size());
 
         for (size_t i = 0; i < info.m_swapChain.m_swapChainImageViews.size(); i++) {
@@ -454,7 +488,7 @@ namespace vvh {
             framebufferInfo.height = info.m_swapChain.m_swapChainExtent.height;
             framebufferInfo.layers = 1;
 
-            if (vkCreateFramebuffer(info.m_device, &framebufferInfo, nullptr, &info.m_swapChain.m_swapChainFramebuffers[i]) != VK_SUCCESS) {
+            if (vkCreateFramebuffer(info.m_device, &framebufferInfo, info.m_pAllocator, &info.m_swapChain.m_swapChainFramebuffers[i]) != VK_SUCCESS) {
                 throw std::runtime_error("failed to create framebuffer!");
             }
         }
@@ -471,6 +505,7 @@ namespace vvh {
 
 	template<typename T = RenFindSupportedFormatInfo>
 	inline auto RenFindSupportedFormat(T&& info) -> VkFormat {
+        VVH_ZONE_FUNCTION;
 
         for (VkFormat format : info.m_candidates) {
             VkFormatProperties props;
@@ -506,10 +541,12 @@ namespace vvh {
 		const VmaAllocator& 	m_vmaAllocator;
 		const SwapChain& 		m_swapChain;
 		DepthImage& 			m_depthImage;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = RenCreateDepthResourcesInfo>
 	inline void RenCreateDepthResources(T&& info) {
+        VVH_ZONE_FUNCTION;
         const VkFormat depthFormat = RenFindDepthFormat(info.m_physicalDevice);
 
         ImgCreateImage2({
@@ -531,7 +568,8 @@ namespace vvh {
 			.m_device = info.m_device, 
 			.m_image  = info.m_depthImage.m_depthImage, 
 			.m_format = depthFormat, 
-			.m_aspects = VK_IMAGE_ASPECT_DEPTH_BIT
+			.m_aspects = VK_IMAGE_ASPECT_DEPTH_BIT,
+			.m_pAllocator = info.m_pAllocator
 		});
     }
 
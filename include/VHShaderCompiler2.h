@@ -0,0 +1,250 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <atomic>
+#include <algorithm>
+#include <iostream>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <unordered_map>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef VVH_SLANG_API
+	#include <slang.h>
+#endif
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Compiles .slang entry points to SPIR-V at runtime and keeps the results in a cache directory. The cache
+	// key hashes the source, every file it imports (transitively), the entry point, stage and defines, so a
+	// warm start only reads the sources and finds the .spv on disk. Misses compile on the thread pool, with
+	// the Slang API if VVH_SLANG_API is defined, otherwise by running slangc. The returned path can be passed
+	// to the ShaderLibrary or a PipelineDesc.
+
+	struct ShaderVariant {
+		std::string m_source;			//.slang file
+		std::string m_entryPoint;		//e.g. vertexMain
+		std::string m_stage;			//vertex, fragment or compute
+		std::vector<std::pair<std::string, std::string>> m_defines;
+	};
+
+	class ShaderCompiler {
+	public:
+		struct Statistics {
+			std::atomic<uint64_t> m_hits{0};
+			std::atomic<uint64_t> m_compiles{0};
+			std::atomic<uint64_t> m_failures{0};
+		};
+
+		/// @brief searchPaths are used to resolve imports besides the directory of the source.
+		void Init(ThreadPool& pool, const std::string& cacheDirectory, const std::vector<std::string>& searchPaths = {},
+					const std::string& compiler = "slangc") {
+			m_pool = &pool;
+			m_cacheDirectory = cacheDirectory;
+			m_searchPaths = searchPaths;
+			m_compiler = compiler;
+			std::filesystem::create_directories(m_cacheDirectory);
+		}
+
+		/// @brief Path of the SPIR-V for a variant, compiled on the pool if it is not cached. Equal variants
+		/// requested while one is compiling share its future.
+		auto Compile(const ShaderVariant& variant) -> std::shared_future<std::string> {
+			uint64_t key = Key(variant);
+			std::string path = CachePath(variant, key);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if( auto it = m_compiling.find(key); it != m_compiling.end() ) return it->second;
+			if( std::filesystem::exists(path) ) {
+				++m_statistics.m_hits;
+				std::promise<std::string> promise;
+				promise.set_value(path);
+				return promise.get_future().share();
+			}
+			auto future = m_pool->Submit([this, variant, path, key]() { Run(variant, path, key); return path; }).share();
+			m_compiling[key] = future;
+			return future;
+		}
+
+		/// @brief Compile several variants in parallel, the futures are in the order of the variants.
+		auto CompileAll(const std::vector<ShaderVariant>& variants) -> std::vector<std::shared_future<std::string>> {
+			std::vector<std::shared_future<std::string>> futures;
+			for( auto& variant : variants ) futures.push_back(Compile(variant));
+			return futures;
+		}
+
+		auto GetStatistics() const -> const Statistics& { return m_statistics; }
+
+		/// @brief The source and all files it imports, e.g. to watch them for changes.
+		auto Dependencies(const std::string& source) const -> std::vector<std::string> {
+			std::set<std::string> files;
+			Collect(std::filesystem::path(source), files);
+			return { files.begin(), files.end() };
+		}
+
+	private:
+		static auto ReadText(const std::filesystem::path& path) -> std::string {
+			std::ifstream file(path, std::ios::binary);
+			if (!file.is_open()) {
+				throw std::runtime_error("failed to open shader source " + path.string() + "!");
+			}
+			std::stringstream stream;
+			stream << file.rdbuf();
+			return stream.str();
+		}
+
+		/// Find an imported module. Slang maps '_' in module names to '-' in file names, the literal name is tried too.
+		auto Resolve(const std::filesystem::path& from, std::string name) const -> std::filesystem::path {
+			if( name.size() > 1 && name.front() == '"' ) name = name.substr(1, name.size() - 2);	//#include "file"
+			std::vector<std::string> candidates{ name };
+			if( name.find('.') == std::string::npos || name.ends_with(".slang") == false ) {
+				std::string dashed = name;
+				std::replace(dashed.begin(), dashed.end(), '_', '-');
+				candidates = { name + ".slang", dashed + ".slang", name };
+			}
+			std::vector<std::filesystem::path> directories{ from.parent_path() };
+			for( auto& path : m_searchPaths ) directories.emplace_back(path);
+			for( auto& directory : directories ) {
+				for( auto& candidate : candidates ) {
+					auto path = directory / candidate;
+					if( std::filesystem::is_regular_file(path) ) return path;
+				}
+			}
+			return {};
+		}
+
+		/// Add path and everything it imports or includes to files.
+		void Collect(const std::filesystem::path& path, std::set<std::string>& files) const {
+			if( !files.insert(path.lexically_normal().string()).second ) return;
+			std::istringstream source(ReadText(path));
+			std::string line;
+			while( std::getline(source, line) ) {
+				std::istringstream words(line);
+				std::string keyword, name;
+				words >> keyword >> name;
+				if( keyword != "import" && keyword != "__include" && keyword != "#include" ) continue;
+				if( !name.empty() && name.back() == ';' ) name.pop_back();
+				if( auto dependency = Resolve(path, name); !dependency.empty() ) Collect(dependency, files);
+			}
+		}
+
+		auto Key(const ShaderVariant& variant) const -> uint64_t {
+			uint64_t hash = 14695981039346656037ull;	//FNV-1a
+			auto mix = [&](const std::string& text) {
+				for( char c : text ) { hash ^= (uint8_t)c; hash *= 1099511628211ull; }
+				hash ^= 0xFF; hash *= 1099511628211ull;		//separator, so "ab"+"c" differs from "a"+"bc"
+			};
+			for( auto& file : Dependencies(variant.m_source) ) { mix(std::filesystem::path(file).filename().string()); mix(ReadText(file)); }
+			mix(variant.m_entryPoint);
+			mix(variant.m_stage);
+			for( auto& [name, value] : variant.m_defines ) { mix(name); mix(value); }
+		#ifdef VVH_SLANG_API
+			mix("slang-api");
+		#else
+			mix(m_compiler);
+		#endif
+			return hash;
+		}
+
+		auto CachePath(const ShaderVariant& variant, uint64_t key) const -> std::string {
+			char hex[17];
+			std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key);
+			auto stem = std::filesystem::path(variant.m_source).stem().string();
+			return (std::filesystem::path(m_cacheDirectory) / (stem + "_" + variant.m_entryPoint + "_" + hex + ".spv")).string();
+		}
+
+		/// Compile into a temporary file and rename it into the cache, so readers never see a partial .spv.
+		void Run(const ShaderVariant& variant, const std::string& path, uint64_t key) {
+			VVH_ZONE("ShaderCompiler::Run");
+			std::stringstream tmp;
+			tmp << path << "." << std::this_thread::get_id() << ".tmp";
+			try {
+				Invoke(variant, tmp.str());
+				std::filesystem::rename(tmp.str(), path);
+				++m_statistics.m_compiles;
+			} catch( ... ) {
+				++m_statistics.m_failures;
+				std::error_code error;
+				std::filesystem::remove(tmp.str(), error);
+				Finish(key);
+				throw;
+			}
+			Finish(key);
+		}
+
+		void Finish(uint64_t key) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_compiling.erase(key);
+		}
+
+	#ifdef VVH_SLANG_API
+		void Invoke(const ShaderVariant& variant, const std::string& output) {
+			thread_local SlangSession* session = spCreateSession(nullptr);	//sessions are not thread safe
+			if (!session) throw std::runtime_error("failed to create Slang session!");
+
+			SlangCompileRequest* request = spCreateCompileRequest(session);
+			spSetCodeGenTarget(request, SLANG_SPIRV);
+			spAddSearchPath(request, std::filesystem::path(variant.m_source).parent_path().string().c_str());
+			for( auto& path : m_searchPaths ) spAddSearchPath(request, path.c_str());
+			for( auto& [name, value] : variant.m_defines ) spAddPreprocessorDefine(request, name.c_str(), value.c_str());
+			int unit = spAddTranslationUnit(request, SLANG_SOURCE_LANGUAGE_SLANG, nullptr);
+			spAddTranslationUnitSourceFile(request, unit, variant.m_source.c_str());
+			SlangStage stage = variant.m_stage == "vertex" ? SLANG_STAGE_VERTEX : variant.m_stage == "fragment" ? SLANG_STAGE_FRAGMENT : SLANG_STAGE_COMPUTE;
+			int entryPoint = spAddEntryPoint(request, unit, variant.m_entryPoint.c_str(), stage);
+
+			std::string error;
+			size_t size = 0;
+			const void* code = nullptr;
+			if( entryPoint < 0 || SLANG_FAILED(spCompile(request)) || !(code = spGetEntryPointCode(request, entryPoint, &size)) ) {
+				const char* diagnostics = spGetDiagnosticOutput(request);
+				error = diagnostics ? diagnostics : "";
+			} else {
+				std::ofstream file(output, std::ios::binary);
+				file.write((const char*)code, size);
+				if( !file ) error = "failed to write " + output;
+			}
+			spDestroyCompileRequest(request);
+			if( !error.empty() ) {
+				std::cerr << error << std::endl;
+				throw std::runtime_error("failed to compile shader " + variant.m_source + ":" + variant.m_entryPoint + "!");
+			}
+		}
+	#else
+		void Invoke(const ShaderVariant& variant, const std::string& output) {
+			std::string log = output + ".log";
+			std::stringstream command;
+			command << m_compiler << " \"" << variant.m_source << "\" -target spirv -entry " << variant.m_entryPoint
+				<< " -stage " << variant.m_stage << " -I \"" << std::filesystem::path(variant.m_source).parent_path().string() << "\"";
+			for( auto& path : m_searchPaths ) command << " -I \"" << path << "\"";
+			for( auto& [name, value] : variant.m_defines ) command << " -D" << name << (value.empty() ? "" : "=" + value);
+			command << " -o \"" << output << "\" > \"" << log << "\" 2>&1";
+
+			int result = std::system(command.str().c_str());
+			std::error_code error;
+			if( result != 0 || !std::filesystem::exists(output) ) {
+				if( std::filesystem::exists(log) ) std::cerr << ReadText(log) << std::endl;
+				std::filesystem::remove(log, error);
+				throw std::runtime_error("failed to compile shader " + variant.m_source + ":" + variant.m_entryPoint + "!");
+			}
+			std::filesystem::remove(log, error);
+		}
+	#endif
+
+		ThreadPool* 			m_pool{nullptr};
+		std::string 			m_cacheDirectory;
+		std::vector<std::string> m_searchPaths;
+		std::string 			m_compiler;
+		std::mutex 				m_mutex;
+		std::unordered_map<uint64_t, std::shared_future<std::string>> m_compiling;
+		Statistics 				m_statistics;
+	};
+
+} // namespace vvh
+
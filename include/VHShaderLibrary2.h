@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <span>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Owns the shader modules of the application. Each SPIR-V file is read once, and its module is found by
+	// the hash of its content, so files with equal content share one module. Modules stay alive until
+	// Destroy. Safe to call from worker threads. If two threads ask for the same new path, one reads it and
+	// the other waits for it.
+
+	class ShaderLibrary {
+	public:
+		struct Module {
+			uint64_t 		m_hash{0};		//FNV-1a of the SPIR-V
+			size_t 			m_size{0};		//bytes
+			VkShaderModule 	m_module{VK_NULL_HANDLE};
+			std::vector<std::string> m_paths;	//files that had this content
+		};
+
+		void Init(VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_device = device;
+			m_pAllocator = pAllocator;
+		}
+
+		void Destroy() {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for( auto& [hash, module] : m_modules ) vkDestroyShaderModule(m_device, module.m_module, m_pAllocator);
+			m_modules.clear();
+			m_paths.clear();
+		}
+
+		/// @brief Module of a SPIR-V file. Only the first call for a path reads the file.
+		auto Load(const std::string& path) -> VkShaderModule {
+			std::promise<uint64_t> promise;
+			std::shared_future<uint64_t> hash;
+			bool owner = false;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				auto [it, inserted] = m_paths.try_emplace(path);
+				if( inserted ) {
+					it->second = promise.get_future().share();
+					owner = true;
+				}
+				hash = it->second;
+			}
+			if( owner ) {
+				try {
+					FileView code(path);
+					++m_fileReads;
+					promise.set_value(Add(code.Span(), path));
+				} catch( ... ) {
+					promise.set_exception(std::current_exception());
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_paths.erase(path);		//a later call may retry, e.g. after the file was written
+				}
+			}
+			uint64_t key = hash.get();
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_modules.at(key).m_module;
+		}
+
+		/// @brief Module of SPIR-V in memory, e.g. from a runtime compiler. Equal code returns the same module.
+		auto Load(std::span<const char> code) -> VkShaderModule {
+			uint64_t key = Add(code, "");
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_modules.at(key).m_module;
+		}
+
+		/// @brief The next Load(path) reads the file again, e.g. after it changed on disk. Modules created
+		/// from the old content stay alive until Destroy, pipelines still in flight may use them.
+		void Invalidate(const std::string& path) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_paths.erase(path);
+		}
+
+		/// @brief Snapshot of all loaded modules.
+		auto Modules() -> std::vector<Module> {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			std::vector<Module> modules;
+			for( auto& [hash, module] : m_modules ) modules.push_back(module);
+			return modules;
+		}
+
+		auto FileReads() const -> uint64_t { return m_fileReads; }
+
+		static auto Hash(std::span<const char> code) -> uint64_t {
+			uint64_t hash = 14695981039346656037ull;	//FNV-1a
+			for( char c : code ) { hash ^= (uint8_t)c; hash *= 1099511628211ull; }
+			return hash;
+		}
+
+	private:
+		/// Find or create the module for code and return its hash. The module is created outside the lock,
+		/// if another thread created the same one meanwhile the duplicate is destroyed again.
+		auto Add(std::span<const char> code, const std::string& path) -> uint64_t {
+			uint64_t hash = Hash(code);
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				auto it = m_modules.find(hash);
+				if( it != m_modules.end() ) {
+					if( !path.empty() ) it->second.m_paths.push_back(path);
+					return hash;
+				}
+			}
+			VkShaderModule module = RenCreateShaderModule({m_device, code, m_pAllocator});
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto [it, inserted] = m_modules.try_emplace(hash, Module{hash, code.size(), module, {}});
+			if( !inserted ) vkDestroyShaderModule(m_device, module, m_pAllocator);
+			if( !path.empty() ) it->second.m_paths.push_back(path);
+			return hash;
+		}
+
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		std::mutex 				m_mutex;
+		std::unordered_map<std::string, std::shared_future<uint64_t>> m_paths;
+		std::unordered_map<uint64_t, Module> m_modules;
+		std::atomic<uint64_t> 	m_fileReads{0};
+	};
+
+} // namespace vvh
+
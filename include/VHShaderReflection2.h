@@ -0,0 +1,373 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <span>
+#include <tuple>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <algorithm>
+#include <unordered_map>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Minimal SPIR-V reflection. Reads the descriptor bindings (set, binding, type, array size) and the push
+	// constant block of a module, and the stages of its entry points. Only what layouts need is parsed, so
+	// one pass over the words is enough.
+
+	struct ReflectedBinding {
+		uint32_t 			m_set{0};
+		uint32_t 			m_binding{0};
+		VkDescriptorType 	m_type{VK_DESCRIPTOR_TYPE_MAX_ENUM};
+		uint32_t 			m_count{1};		//runtime sized arrays are reported with 1
+		VkShaderStageFlags 	m_stages{0};
+	};
+
+	struct ShaderReflection {
+		VkShaderStageFlags 				m_stages{0};
+		std::vector<ReflectedBinding> 	m_bindings;			//sorted by set and binding
+		std::vector<VkPushConstantRange> m_pushConstantRanges;
+	};
+
+	/// @brief Reflect a SPIR-V module. If entryPoint is given, only its stage is used, and for SPIR-V 1.4 and
+	/// later only the resources it references.
+	inline auto ReflectSpirv(std::span<const uint32_t> code, const std::string& entryPoint = "") -> ShaderReflection {
+		if( code.size() < 5 || code[0] != 0x07230203 ) {
+			throw std::runtime_error("failed to reflect shader, not SPIR-V!");
+		}
+		enum Op : uint16_t { OpEntryPoint = 15, OpTypeInt = 21, OpTypeFloat = 22, OpTypeVector = 23, OpTypeMatrix = 24,
+			OpTypeImage = 25, OpTypeSampler = 26, OpTypeSampledImage = 27, OpTypeArray = 28, OpTypeRuntimeArray = 29,
+			OpTypeStruct = 30, OpTypePointer = 32, OpConstant = 43, OpVariable = 59, OpDecorate = 71, OpMemberDecorate = 72,
+			OpTypeAccelerationStructure = 5341 };
+		enum Decoration : uint32_t { Block = 2, BufferBlock = 3, ArrayStride = 6, MatrixStride = 7, Binding = 33, DescriptorSet = 34, Offset = 35 };
+		enum StorageClass : uint32_t { UniformConstant = 0, Uniform = 2, PushConstant = 9, StorageBuffer = 12 };
+
+		struct Id {
+			uint16_t 	m_op{0};
+			uint32_t 	m_type{0};			//element, pointee or component type
+			uint32_t 	m_storage{0};		//pointer and variable storage class
+			uint32_t 	m_value{0};			//int/float width, vector/matrix/array count, constant value, image dim
+			uint32_t 	m_sampled{0};		//image: 1 sampled, 2 storage
+			uint32_t 	m_set{~0u}, m_binding{~0u}, m_arrayStride{0};
+			bool 		m_block{false}, m_bufferBlock{false};
+			std::vector<uint32_t> m_members, m_offsets, m_matrixStrides;
+		};
+		std::vector<Id> ids(code[3]);
+		std::vector<uint32_t> variables;
+		ShaderReflection reflection;
+		std::vector<uint32_t> interface;
+		bool found = entryPoint.empty();
+
+		auto stageOf = [](uint32_t model) -> VkShaderStageFlags {
+			switch( model ) {
+				case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+				case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+				case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+				case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+				case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+				case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+				case 5364: return VK_SHADER_STAGE_TASK_BIT_EXT;
+				case 5365: return VK_SHADER_STAGE_MESH_BIT_EXT;
+				default: return (model >= 5313 && model <= 5318) ? VK_SHADER_STAGE_ALL : 0;	//ray tracing stages
+			}
+		};
+		auto id = [&](uint32_t i) -> Id& {
+			if( i >= ids.size() ) throw std::runtime_error("failed to reflect shader, id out of bounds!");
+			return ids[i];
+		};
+
+		for( size_t i = 5; i < code.size(); ) {
+			uint16_t op = code[i] & 0xFFFF;
+			uint16_t count = code[i] >> 16;
+			if( count == 0 || i + count > code.size() ) throw std::runtime_error("failed to reflect shader, invalid instruction!");
+			const uint32_t* w = &code[i];
+			switch( op ) {
+				case OpEntryPoint: {
+					std::string name((const char*)&w[3]);
+					size_t nameWords = name.size() / 4 + 1;
+					if( !entryPoint.empty() && name != entryPoint ) break;
+					found = true;
+					reflection.m_stages |= stageOf(w[1]);
+					interface.insert(interface.end(), w + 3 + nameWords, w + count);
+					break;
+				}
+				case OpTypeInt: case OpTypeFloat: id(w[1]).m_op = op; id(w[1]).m_value = w[2]; break;
+				case OpTypeVector: case OpTypeMatrix: id(w[1]).m_op = op; id(w[1]).m_type = w[2]; id(w[1]).m_value = w[3]; break;
+				case OpTypeImage: id(w[1]).m_op = op; id(w[1]).m_value = w[3]; id(w[1]).m_sampled = w[7]; break;
+				case OpTypeSampler: case OpTypeAccelerationStructure: id(w[1]).m_op = op; break;
+				case OpTypeSampledImage: case OpTypeRuntimeArray: id(w[1]).m_op = op; id(w[1]).m_type = w[2]; break;
+				case OpTypeArray: id(w[1]).m_op = op; id(w[1]).m_type = w[2]; id(w[1]).m_value = id(w[3]).m_value; break;
+				case OpTypeStruct: id(w[1]).m_op = op; id(w[1]).m_members.assign(w + 2, w + count); break;
+				case OpTypePointer: id(w[1]).m_op = op; id(w[1]).m_storage = w[2]; id(w[1]).m_type = w[3]; break;
+				case OpConstant: id(w[2]).m_op = op; id(w[2]).m_value = w[3]; break;
+				case OpVariable: id(w[2]).m_op = op; id(w[2]).m_type = w[1]; id(w[2]).m_storage = w[3]; variables.push_back(w[2]); break;
+				case OpDecorate: {
+					Id& target = id(w[1]);
+					if( w[2] == Block ) target.m_block = true;
+					if( w[2] == BufferBlock ) target.m_bufferBlock = true;
+					if( w[2] == ArrayStride ) target.m_arrayStride = w[3];
+					if( w[2] == Binding ) target.m_binding = w[3];
+					if( w[2] == DescriptorSet ) target.m_set = w[3];
+					break;
+				}
+				case OpMemberDecorate: {
+					Id& target = id(w[1]);
+					auto& values = w[3] == Offset ? target.m_offsets : target.m_matrixStrides;
+					if( w[3] != Offset && w[3] != MatrixStride ) break;
+					if( values.size() <= w[2] ) values.resize(w[2] + 1, 0);
+					values[w[2]] = w[4];
+					break;
+				}
+			}
+			i += count;
+		}
+		if( !found ) throw std::runtime_error("failed to reflect shader, entry point " + entryPoint + " not found!");
+
+		//SPIR-V 1.4 lists all global variables an entry point uses in its interface, older versions only inputs and outputs
+		bool filter = !entryPoint.empty() && code[1] >= 0x00010400;
+		auto size = [&](auto& self, uint32_t type, uint32_t matrixStride) -> uint32_t {
+			Id& t = id(type);
+			switch( t.m_op ) {
+				case OpTypeInt: case OpTypeFloat: return t.m_value / 8;
+				case OpTypeVector: return t.m_value * self(self, t.m_type, 0);
+				case OpTypeMatrix: return t.m_value * (matrixStride ? matrixStride : self(self, t.m_type, 0));
+				case OpTypeArray: return t.m_value * (t.m_arrayStride ? t.m_arrayStride : self(self, t.m_type, matrixStride));
+				case OpTypeStruct: {
+					uint32_t end = 0;
+					for( uint32_t m = 0; m < t.m_members.size(); ++m ) {
+						uint32_t offset = m < t.m_offsets.size() ? t.m_offsets[m] : end;
+						uint32_t stride = m < t.m_matrixStrides.size() ? t.m_matrixStrides[m] : 0;
+						end = std::max(end, offset + self(self, t.m_members[m], stride));
+					}
+					return end;
+				}
+				default: return 0;
+			}
+		};
+
+		for( uint32_t variable : variables ) {
+			Id& var = id(variable);
+			if( filter && std::find(interface.begin(), interface.end(), variable) == interface.end() ) continue;
+			uint32_t typeId = id(var.m_type).m_type;	//pointee
+
+			if( var.m_storage == PushConstant ) {
+				Id& block = id(typeId);
+				uint32_t offset = block.m_offsets.empty() ? 0 : *std::min_element(block.m_offsets.begin(), block.m_offsets.end());
+				reflection.m_pushConstantRanges.push_back({ reflection.m_stages, offset, size(size, typeId, 0) - offset });
+				continue;
+			}
+			if( var.m_storage != UniformConstant && var.m_storage != Uniform && var.m_storage != StorageBuffer ) continue;
+
+			ReflectedBinding binding{ .m_set = var.m_set == ~0u ? 0 : var.m_set, .m_binding = var.m_binding == ~0u ? 0 : var.m_binding,
+										.m_stages = reflection.m_stages };
+			while( id(typeId).m_op == OpTypeArray || id(typeId).m_op == OpTypeRuntimeArray ) {
+				if( id(typeId).m_op == OpTypeArray ) binding.m_count *= id(typeId).m_value;
+				typeId = id(typeId).m_type;
+			}
+			Id& type = id(typeId);
+			switch( type.m_op ) {
+				case OpTypeSampler: binding.m_type = VK_DESCRIPTOR_TYPE_SAMPLER; break;
+				case OpTypeSampledImage: binding.m_type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; break;
+				case OpTypeAccelerationStructure: binding.m_type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR; break;
+				case OpTypeImage:
+					if( type.m_value == 5 ) binding.m_type = type.m_sampled == 1 ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+					else if( type.m_value == 6 ) binding.m_type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					else binding.m_type = type.m_sampled == 1 ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+					break;
+				case OpTypeStruct:
+					if( var.m_storage == StorageBuffer || type.m_bufferBlock ) binding.m_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+					else if( type.m_block ) binding.m_type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					break;
+			}
+			if( binding.m_type != VK_DESCRIPTOR_TYPE_MAX_ENUM ) reflection.m_bindings.push_back(binding);
+		}
+		std::sort(reflection.m_bindings.begin(), reflection.m_bindings.end(),
+			[](auto& a, auto& b) { return std::tie(a.m_set, a.m_binding) < std::tie(b.m_set, b.m_binding); });
+		return reflection;
+	}
+
+	inline auto ReflectSpirv(std::span<const char> code, const std::string& entryPoint = "") -> ShaderReflection {
+		std::vector<uint32_t> words(code.size() / 4);
+		std::memcpy(words.data(), code.data(), words.size() * 4);	//mapped files need not be aligned
+		return ReflectSpirv(std::span<const uint32_t>(words), entryPoint);
+	}
+
+	/// @brief Combine the stages of a pipeline. Bindings used by several stages get all their stage bits,
+	/// push constant ranges that are equal in several stages are merged.
+	inline auto ReflectMerge(const std::vector<ShaderReflection>& shaders) -> ShaderReflection {
+		ShaderReflection merged;
+		for( auto& shader : shaders ) {
+			merged.m_stages |= shader.m_stages;
+			for( auto& binding : shader.m_bindings ) {
+				auto it = std::find_if(merged.m_bindings.begin(), merged.m_bindings.end(),
+					[&](auto& b) { return b.m_set == binding.m_set && b.m_binding == binding.m_binding; });
+				if( it == merged.m_bindings.end() ) { merged.m_bindings.push_back(binding); continue; }
+				if( it->m_type != binding.m_type || it->m_count != binding.m_count ) {
+					throw std::runtime_error("failed to merge shader reflection, set " + std::to_string(binding.m_set)
+						+ " binding " + std::to_string(binding.m_binding) + " differs between stages!");
+				}
+				it->m_stages |= binding.m_stages;
+			}
+			for( auto& range : shader.m_pushConstantRanges ) {
+				auto it = std::find_if(merged.m_pushConstantRanges.begin(), merged.m_pushConstantRanges.end(),
+					[&](auto& r) { return r.offset == range.offset && r.size == range.size; });
+				if( it == merged.m_pushConstantRanges.end() ) merged.m_pushConstantRanges.push_back(range);
+				else it->stageFlags |= range.stageFlags;
+			}
+		}
+		std::sort(merged.m_bindings.begin(), merged.m_bindings.end(),
+			[](auto& a, auto& b) { return std::tie(a.m_set, a.m_binding) < std::tie(b.m_set, b.m_binding); });
+		return merged;
+	}
+
+
+	//---------------------------------------------------------------------------------------------
+	// Creates descriptor set layouts and pipeline layouts and returns the existing object for an equal
+	// description, so pipelines with the same resources share one pipeline layout and descriptor sets stay
+	// bound when switching between them. Layouts live until Destroy. Safe to call from worker threads.
+
+	struct ShaderLayout {
+		std::vector<VkDescriptorSetLayout> 	m_setLayouts;		//index is the set number, unused sets get an empty layout
+		std::vector<VkPushConstantRange> 	m_pushConstantRanges;
+		VkPipelineLayout 					m_pipelineLayout{VK_NULL_HANDLE};
+		ShaderReflection 					m_reflection;		//merged over the stages
+	};
+
+	class LayoutCache {
+	public:
+		struct Statistics {
+			uint64_t m_requests{0};
+			uint64_t m_setLayouts{0};		//created
+			uint64_t m_pipelineLayouts{0};	//created
+		};
+
+		/// @brief With descriptorBuffer, all set layouts are made for a DescriptorBuffer instead of pools.
+		void Init(VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr, bool descriptorBuffer = false) {
+			m_device = device;
+			m_pAllocator = pAllocator;
+			m_descriptorBuffer = descriptorBuffer;
+		}
+
+		void Destroy() {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for( auto& [key, layout] : m_pipelineLayouts ) vkDestroyPipelineLayout(m_device, layout, m_pAllocator);
+			for( auto& [key, layout] : m_setLayouts ) vkDestroyDescriptorSetLayout(m_device, layout, m_pAllocator);
+			m_pipelineLayouts.clear();
+			m_setLayouts.clear();
+			m_bindings.clear();
+		}
+
+		/// @brief Set layout with exactly these bindings, in any order. A push descriptor layout is a different layout.
+		auto SetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings, bool pushDescriptor = false) -> VkDescriptorSetLayout {
+			std::sort(bindings.begin(), bindings.end(), [](auto& a, auto& b) { return a.binding < b.binding; });
+			std::vector<uint64_t> key;
+			for( auto& b : bindings ) {
+				key.push_back((uint64_t)b.binding << 32 | (uint32_t)b.descriptorType);
+				key.push_back((uint64_t)b.descriptorCount << 32 | b.stageFlags);
+			}
+			if( pushDescriptor ) key.push_back(~0ull);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto [it, inserted] = m_setLayouts.try_emplace(std::move(key), VK_NULL_HANDLE);
+			if( !inserted ) return it->second;
+			try {
+				RenCreateDescriptorSetLayout({
+					.m_device 				= m_device,
+					.m_bindings 			= bindings,
+					.m_descriptorSetLayout 	= it->second,
+					.m_pAllocator 			= m_pAllocator,
+					.m_keepBindings 		= true,
+					.m_pushDescriptor 		= pushDescriptor,
+					.m_descriptorBuffer 	= m_descriptorBuffer
+				});
+			} catch( ... ) {
+				m_setLayouts.erase(it);
+				throw;
+			}
+			++m_statistics.m_setLayouts;
+			m_bindings[it->second] = bindings;
+			return it->second;
+		}
+
+		/// @brief Bindings of a set layout created by this cache, empty for other layouts.
+		auto Bindings(VkDescriptorSetLayout layout) -> std::vector<VkDescriptorSetLayoutBinding> {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_bindings.find(layout);
+			return it == m_bindings.end() ? std::vector<VkDescriptorSetLayoutBinding>{} : it->second;
+		}
+
+		auto PipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges) -> VkPipelineLayout {
+			std::vector<uint64_t> key;
+			for( auto layout : setLayouts ) key.push_back((uint64_t)layout);
+			key.push_back(~0ull);
+			for( auto& r : pushConstantRanges ) key.push_back((uint64_t)r.stageFlags << 48 | (uint64_t)r.offset << 24 | r.size);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto [it, inserted] = m_pipelineLayouts.try_emplace(std::move(key), VK_NULL_HANDLE);
+			if( !inserted ) return it->second;
+
+			VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+			pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			pipelineLayoutInfo.setLayoutCount = (uint32_t)setLayouts.size();
+			pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+			pipelineLayoutInfo.pushConstantRangeCount = (uint32_t)pushConstantRanges.size();
+			pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.empty() ? nullptr : pushConstantRanges.data();
+			if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, m_pAllocator, &it->second) != VK_SUCCESS) {
+				m_pipelineLayouts.erase(it);
+				throw std::runtime_error("failed to create pipeline layout!");
+			}
+			++m_statistics.m_pipelineLayouts;
+			return it->second;
+		}
+
+		/// @brief Layouts for the merged reflection of a pipeline's stages. The set pushDescriptorSet, e.g. for
+		/// per-draw resources, gets a push descriptor layout to be written with ComPushDescriptors.
+		auto Create(const std::vector<ShaderReflection>& stages, std::optional<uint32_t> pushDescriptorSet = std::nullopt) -> ShaderLayout {
+			ShaderLayout layout;
+			layout.m_reflection = ReflectMerge(stages);
+			layout.m_pushConstantRanges = layout.m_reflection.m_pushConstantRanges;
+			uint32_t sets = layout.m_reflection.m_bindings.empty() ? 0 : layout.m_reflection.m_bindings.back().m_set + 1;
+			std::vector<std::vector<VkDescriptorSetLayoutBinding>> bindings(sets);
+			for( auto& b : layout.m_reflection.m_bindings ) {
+				bindings[b.m_set].push_back({ b.m_binding, b.m_type, b.m_count, b.m_stages, nullptr });
+			}
+			for( uint32_t set = 0; set < sets; ++set ) layout.m_setLayouts.push_back(SetLayout(bindings[set], set == pushDescriptorSet));
+			layout.m_pipelineLayout = PipelineLayout(layout.m_setLayouts, layout.m_pushConstantRanges);
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				++m_statistics.m_requests;
+			}
+			return layout;
+		}
+
+		/// @brief Layouts for SPIR-V files, e.g. the vertex and fragment shader of a pipeline.
+		auto Create(const std::vector<std::string>& spirvPaths, std::optional<uint32_t> pushDescriptorSet = std::nullopt) -> ShaderLayout {
+			std::vector<ShaderReflection> stages;
+			for( auto& path : spirvPaths ) {
+				if( path.empty() ) continue;
+				FileView code(path);
+				stages.push_back(ReflectSpirv(code.Span()));
+			}
+			return Create(stages, pushDescriptorSet);
+		}
+
+		auto GetStatistics() -> Statistics {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_statistics;
+		}
+
+	private:
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		bool 					m_descriptorBuffer{false};
+		std::mutex 				m_mutex;
+		std::map<std::vector<uint64_t>, VkDescriptorSetLayout> 	m_setLayouts;
+		std::map<std::vector<uint64_t>, VkPipelineLayout> 		m_pipelineLayouts;
+		std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSetLayoutBinding>> m_bindings;
+		Statistics 				m_statistics;
+	};
+
+} // namespace vvh
+
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <optional>
+#include <future>
+#include <chrono>
+#include <iostream>
+#include <filesystem>
+
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <unistd.h>
+	#include <cerrno>
+#endif
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Reports files in a set of directories that were written since the last Poll(). Uses inotify on Linux
+	// and compares modification times otherwise, or if inotify is not available. Poll() never blocks.
+
+	class FileWatcher {
+	public:
+		void Init(const std::vector<std::string>& directories, const std::vector<std::string>& extensions = { ".slang", ".spv" },
+					std::chrono::milliseconds pollInterval = std::chrono::milliseconds(500)) {
+			m_extensions = extensions;
+			m_pollInterval = pollInterval;
+		#ifdef __linux__
+			m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			for( auto& directory : directories ) {
+				if( m_fd < 0 ) break;
+				int wd = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+				if( wd >= 0 ) m_watches[wd] = directory;
+			}
+			if( m_fd >= 0 && m_watches.size() == directories.size() ) return;
+			Destroy();
+		#endif
+			m_directories = directories;	//polling fallback
+			Scan(m_times);
+			m_lastPoll = std::chrono::steady_clock::now();
+		}
+
+		void Destroy() {
+		#ifdef __linux__
+			if( m_fd >= 0 ) close(m_fd);
+			m_fd = -1;
+			m_watches.clear();
+		#endif
+			m_directories.clear();
+			m_times.clear();
+		}
+
+		/// @brief Files changed since the last call, each reported once.
+		auto Poll() -> std::vector<std::string> {
+			std::set<std::string> changed;
+		#ifdef __linux__
+			if( m_fd >= 0 ) {
+				alignas(inotify_event) char buffer[4096];
+				ssize_t size;
+				while( (size = read(m_fd, buffer, sizeof(buffer))) > 0 ) {
+					for( char* p = buffer; p < buffer + size; p += sizeof(inotify_event) + ((inotify_event*)p)->len ) {
+						auto* event = (inotify_event*)p;
+						if( event->len == 0 || !m_watches.contains(event->wd) ) continue;
+						auto path = (std::filesystem::path(m_watches[event->wd]) / event->name).string();
+						if( Matches(path) ) changed.insert(path);
+					}
+				}
+				return { changed.begin(), changed.end() };
+			}
+		#endif
+			auto now = std::chrono::steady_clock::now();
+			if( now - m_lastPoll < m_pollInterval ) return {};
+			m_lastPoll = now;
+			std::map<std::string, std::filesystem::file_time_type> times;
+			Scan(times);
+			for( auto& [path, time] : times ) {
+				auto it = m_times.find(path);
+				if( it == m_times.end() || it->second != time ) changed.insert(path);
+			}
+			m_times.swap(times);
+			return { changed.begin(), changed.end() };
+		}
+
+	private:
+		auto Matches(const std::string& path) const -> bool {
+			auto extension = std::filesystem::path(path).extension().string();
+			return std::find(m_extensions.begin(), m_extensions.end(), extension) != m_extensions.end();
+		}
+
+		void Scan(std::map<std::string, std::filesystem::file_time_type>& times) const {
+			std::error_code error;
+			for( auto& directory : m_directories ) {
+				for( auto& entry : std::filesystem::directory_iterator(directory, error) ) {
+					if( entry.is_regular_file(error) && Matches(entry.path().string()) ) {
+						times[entry.path().string()] = entry.last_write_time(error);
+					}
+				}
+			}
+		}
+
+	#ifdef __linux__
+		int 					m_fd{-1};
+		std::map<int, std::string> m_watches;
+	#endif
+		std::vector<std::string> m_extensions;
+		std::vector<std::string> m_directories;
+		std::map<std::string, std::filesystem::file_time_type> m_times;
+		std::chrono::milliseconds m_pollInterval{500};
+		std::chrono::steady_clock::time_point m_lastPoll;
+	};
+
+
+	//---------------------------------------------------------------------------------------------
+	// Rebuilds pipelines whose shaders changed on disk while the application runs. A pipeline is registered
+	// with its description and either the Slang variants it is compiled from or the SPIR-V files it uses.
+	// When the watcher reports a change to one of their files (sources and imports), the variants are
+	// recompiled and the pipeline is rebuilt on the thread pool. Update() swaps the new pipeline into the
+	// caller's slot at the frame boundary and destroys the old one once no frame in flight can use it.
+	// If compiling or building fails, the error is printed and the old pipeline stays.
+
+	class ShaderReload {
+	public:
+		struct Statistics {
+			uint64_t m_changes{0};		//file change events
+			uint64_t m_reloads{0};		//pipelines swapped
+			uint64_t m_failures{0};		//compiles or builds that kept the old pipeline
+		};
+
+		void Init(VkDevice device, ShaderCompiler& compiler, ShaderLibrary& library, PipelineBuilder& builder,
+					const std::vector<std::string>& directories, uint32_t framesInFlight = MAX_FRAMES_IN_FLIGHT,
+					const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_device = device;
+			m_compiler = &compiler;
+			m_library = &library;
+			m_builder = &builder;
+			m_framesInFlight = framesInFlight;
+			m_pAllocator = pAllocator;
+			m_watcher.Init(directories);
+		}
+
+		/// @brief Wait for running rebuilds and destroy the pipelines that are not in a slot.
+		void Destroy() {
+			for( auto& entry : m_entries ) {
+				for( auto& future : entry.m_compiles ) if( future.valid() ) future.wait();
+				if( entry.m_build.valid() ) {
+					try { DestroyPipeline(entry.m_build.get(), entry.m_desc.m_pipelineLayout == VK_NULL_HANDLE); } catch( ... ) {}
+				}
+			}
+			for( auto& retired : m_retired ) DestroyPipeline(retired.m_pipeline, retired.m_ownsLayout);
+			m_retired.clear();
+			m_entries.clear();
+			m_watcher.Destroy();
+		}
+
+		/// @brief Rebuild slot from Slang variants. desc's shader paths are replaced by the compiled SPIR-V.
+		/// The slot must stay at its address, and the caller keeps owning the pipeline in it.
+		void Add(Pipeline& slot, PipelineDesc desc, ShaderVariant vert, std::optional<ShaderVariant> frag = std::nullopt) {
+			std::vector<ShaderVariant> variants{ std::move(vert) };
+			if( frag ) variants.push_back(std::move(*frag));
+			Entry entry{ &slot, std::move(desc), std::move(variants) };
+			Track(entry);
+			m_entries.push_back(std::move(entry));
+		}
+
+		/// @brief Rebuild slot when the SPIR-V files of desc change.
+		void Add(Pipeline& slot, PipelineDesc desc) {
+			Entry entry{ &slot, std::move(desc), {} };
+			Track(entry);
+			m_entries.push_back(std::move(entry));
+		}
+
+		/// @brief Call once per frame, after waiting for the fence of the frame about to be recorded.
+		void Update(uint64_t frameNumber) {
+			VVH_ZONE("ShaderReload::Update");
+			auto changed = m_watcher.Poll();
+			m_statistics.m_changes += changed.size();
+			for( auto& path : changed ) {
+				if( path.ends_with(".spv") ) m_library->Invalidate(path);
+				for( auto& entry : m_entries ) {
+					if( entry.m_dependencies.contains(std::filesystem::path(path).lexically_normal().string()) ) entry.m_dirty = true;
+				}
+			}
+
+			for( auto& entry : m_entries ) {
+				if( !entry.m_compiles.empty() && Ready(entry.m_compiles) ) Build(entry);
+				if( entry.m_build.valid() && entry.m_build.wait_for(std::chrono::seconds(0)) == std::future_status::ready ) Swap(entry, frameNumber);
+				if( entry.m_dirty && entry.m_compiles.empty() && !entry.m_build.valid() ) Compile(entry);
+			}
+
+			std::erase_if(m_retired, [&](auto& retired) {
+				if( frameNumber < retired.m_frame + m_framesInFlight ) return false;
+				DestroyPipeline(retired.m_pipeline, retired.m_ownsLayout);
+				return true;
+			});
+		}
+
+		auto GetStatistics() const -> const Statistics& { return m_statistics; }
+
+	private:
+		struct Entry {
+			Pipeline* 		m_slot;
+			PipelineDesc 	m_desc;
+			std::vector<ShaderVariant> m_variants;		//empty if desc uses SPIR-V files
+			std::set<std::string> m_dependencies;		//normalized paths of all files the pipeline is made from
+			std::vector<std::shared_future<std::string>> m_compiles;
+			PipelineBuilder::Future m_build;
+			bool 			m_dirty{false};
+		};
+
+		struct Retired {
+			Pipeline 	m_pipeline;
+			uint64_t 	m_frame;		//frame number when it was replaced
+			bool 		m_ownsLayout;	//false for a shared layout
+		};
+
+		void Track(Entry& entry) {
+			entry.m_dependencies.clear();
+			std::vector<std::string> files;
+			for( auto& variant : entry.m_variants ) {
+				try { files = m_compiler->Dependencies(variant.m_source); } catch( ... ) { files = { variant.m_source }; }
+				for( auto& file : files ) entry.m_dependencies.insert(std::filesystem::path(file).lexically_normal().string());
+			}
+			if( entry.m_variants.empty() ) {
+				for( auto& path : { entry.m_desc.m_vertShaderPath, entry.m_desc.m_fragShaderPath } ) {
+					if( !path.empty() ) entry.m_dependencies.insert(std::filesystem::path(path).lexically_normal().string());
+				}
+			}
+		}
+
+		static auto Ready(const std::vector<std::shared_future<std::string>>& futures) -> bool {
+			return std::all_of(futures.begin(), futures.end(),
+				[](auto& future) { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+		}
+
+		/// Start compiling the variants, without variants go straight to building.
+		void Compile(Entry& entry) {
+			entry.m_dirty = false;
+			if( entry.m_variants.empty() ) { entry.m_build = m_builder->Submit(entry.m_desc); return; }
+			try {
+				Track(entry);	//imports may have changed
+				entry.m_compiles = m_compiler->CompileAll(entry.m_variants);
+			} catch( std::exception& e ) {
+				Fail(e.what());
+			}
+		}
+
+		void Build(Entry& entry) {
+			auto compiles = std::move(entry.m_compiles);
+			entry.m_compiles.clear();
+			try {
+				PipelineDesc desc = entry.m_desc;
+				desc.m_vertShaderPath = compiles[0].get();
+				if( compiles.size() > 1 ) desc.m_fragShaderPath = compiles[1].get();
+				entry.m_build = m_builder->Submit(std::move(desc));
+			} catch( std::exception& e ) {
+				Fail(e.what());
+			}
+		}
+
+		void Swap(Entry& entry, uint64_t frameNumber) {
+			auto build = std::move(entry.m_build);
+			entry.m_build = {};
+			try {
+				Pipeline pipeline = build.get();
+				m_retired.push_back({ *entry.m_slot, frameNumber, entry.m_desc.m_pipelineLayout == VK_NULL_HANDLE });
+				*entry.m_slot = pipeline;
+				++m_statistics.m_reloads;
+			} catch( std::exception& e ) {
+				Fail(e.what());
+			}
+		}
+
+		void Fail(const std::string& error) {
+			++m_statistics.m_failures;
+			std::cerr << "shader reload failed, keeping the old pipeline: " << error << std::endl;
+		}
+
+		void DestroyPipeline(const Pipeline& pipeline, bool ownsLayout) {
+			vkDestroyPipeline(m_device, pipeline.m_pipeline, m_pAllocator);
+			if( ownsLayout ) vkDestroyPipelineLayout(m_device, pipeline.m_pipelineLayout, m_pAllocator);
+		}
+
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		ShaderCompiler* 		m_compiler{nullptr};
+		ShaderLibrary* 			m_library{nullptr};
+		PipelineBuilder* 		m_builder{nullptr};
+		uint32_t 				m_framesInFlight{MAX_FRAMES_IN_FLIGHT};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		FileWatcher 			m_watcher;
+		std::vector<Entry> 		m_entries;
+		std::vector<Retired> 	m_retired;
+		Statistics 				m_statistics;
+	};
+
+} // namespace vvh
+
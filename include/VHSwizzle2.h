@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define VVH_SWIZZLE_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define VVH_TARGET(x)
+	#else
+		#include <cpuid.h>
+		#define VVH_TARGET(x) __attribute__((target(x)))
+	#endif
+#endif
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Channel swizzle of 8 bit, 4 channel pixels, e.g. BGRA -> RGBA or RGBA -> RGB.
+	// Uses a byte shuffle (SSSE3 pshufb, AVX2 vpshufb) if the CPU supports it, chosen at runtime.
+
+	enum class SwizzleIsa { Scalar, SSSE3, AVX2 };
+
+	/// For each destination channel the source channel it is taken from. m_channels is 4 or 3 (drop alpha).
+	struct SwizzlePattern {
+		uint8_t 	m_source[4]{0, 1, 2, 3};
+		uint32_t 	m_channels{4};
+	};
+
+	/// @brief Pattern from the destination positions of the source channels, as used by ImgSwapChannels.
+	inline auto SwzPatternFromPositions(int r, int g, int b, int a, uint32_t channels = 4) -> SwizzlePattern {
+		SwizzlePattern pattern;
+		pattern.m_source[r] = 0;
+		pattern.m_source[g] = 1;
+		pattern.m_source[b] = 2;
+		pattern.m_source[a] = 3;
+		pattern.m_channels = channels;
+		return pattern;
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	inline auto SwzDetectIsa() -> SwizzleIsa {
+	#ifdef VVH_SWIZZLE_X86
+		auto cpuid = [](int leaf, int sub, unsigned regs[4]) {
+		#if defined(_MSC_VER) && !defined(__clang__)
+			__cpuidex((int*)regs, leaf, sub);
+		#else
+			__cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+		#endif
+		};
+		unsigned regs[4];
+		cpuid(0, 0, regs);
+		unsigned maxLeaf = regs[0];
+		cpuid(1, 0, regs);
+		bool ssse3 = regs[2] & (1u << 9);
+		bool osxsave = regs[2] & (1u << 27);
+		bool avx = regs[2] & (1u << 28);
+		if( maxLeaf >= 7 && osxsave && avx ) {
+		#if defined(_MSC_VER) && !defined(__clang__)
+			unsigned long long xcr0 = _xgetbv(0);
+		#else
+			unsigned eax, edx;
+			__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			unsigned long long xcr0 = ((unsigned long long)edx << 32) | eax;
+		#endif
+			cpuid(7, 0, regs);
+			if( (xcr0 & 0x6) == 0x6 && (regs[1] & (1u << 5)) ) return SwizzleIsa::AVX2;	//OS saves YMM state, CPU has AVX2
+		}
+		if( ssse3 ) return SwizzleIsa::SSSE3;
+	#endif
+		return SwizzleIsa::Scalar;
+	}
+
+	/// @brief The best instruction set of this CPU, detected once.
+	inline auto SwzBestIsa() -> SwizzleIsa {
+		static const SwizzleIsa isa = SwzDetectIsa();
+		return isa;
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	inline void SwzScalar(const uint8_t* src, uint8_t* dst, size_t pixels, const SwizzlePattern& pattern) {
+		const uint8_t s0 = pattern.m_source[0], s1 = pattern.m_source[1], s2 = pattern.m_source[2], s3 = pattern.m_source[3];
+		if( pattern.m_channels == 4 ) {
+			for( size_t i = 0; i < pixels; ++i, src += 4, dst += 4 ) {
+				uint8_t r = src[s0], g = src[s1], b = src[s2], a = src[s3];
+				dst[0] = r; dst[1] = g; dst[2] = b; dst[3] = a;
+			}
+		} else {
+			for( size_t i = 0; i < pixels; ++i, src += 4, dst += 3 ) {
+				uint8_t r = src[s0], g = src[s1], b = src[s2];
+				dst[0] = r; dst[1] = g; dst[2] = b;
+			}
+		}
+	}
+
+#ifdef VVH_SWIZZLE_X86
+
+	/// Shuffle control for 4 pixels, unused bytes are zeroed (high bit set).
+	inline void SwzShuffleMask(const SwizzlePattern& pattern, uint8_t mask[16]) {
+		for( int i = 0; i < 16; ++i ) mask[i] = 0x80;
+		for( uint32_t p = 0; p < 4; ++p ) {
+			for( uint32_t c = 0; c < pattern.m_channels; ++c ) {
+				mask[p * pattern.m_channels + c] = (uint8_t)(p * 4 + pattern.m_source[c]);
+			}
+		}
+	}
+
+	VVH_TARGET("ssse3")
+	inline void SwzSSSE3(const uint8_t* src, uint8_t* dst, size_t pixels, const SwizzlePattern& pattern) {
+		alignas(16) uint8_t maskBytes[16];
+		SwzShuffleMask(pattern, maskBytes);
+		const __m128i mask = _mm_load_si128((const __m128i*)maskBytes);
+		size_t i = 0;
+		if( pattern.m_channels == 4 ) {
+			for( ; i + 4 <= pixels; i += 4 ) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+				_mm_storeu_si128((__m128i*)(dst + 4 * i), _mm_shuffle_epi8(v, mask));
+			}
+		} else {
+			//each store writes 16 bytes of which 12 are valid, so stop while 16 bytes still fit
+			for( ; i + 6 <= pixels; i += 4 ) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+				_mm_storeu_si128((__m128i*)(dst + 3 * i), _mm_shuffle_epi8(v, mask));
+			}
+		}
+		SwzScalar(src + 4 * i, dst + pattern.m_channels * i, pixels - i, pattern);
+	}
+
+	VVH_TARGET("avx2")
+	inline void SwzAVX2(const uint8_t* src, uint8_t* dst, size_t pixels, const SwizzlePattern& pattern) {
+		alignas(16) uint8_t maskBytes[16];
+		SwzShuffleMask(pattern, maskBytes);
+		const __m256i mask = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)maskBytes));	//vpshufb works per 128 bit lane
+		size_t i = 0;
+		if( pattern.m_channels == 4 ) {
+			for( ; i + 8 <= pixels; i += 8 ) {
+				__m256i v = _mm256_loadu_si256((const __m256i*)(src + 4 * i));
+				_mm256_storeu_si256((__m256i*)(dst + 4 * i), _mm256_shuffle_epi8(v, mask));
+			}
+		} else {
+			//close the 4 byte gap between the 12 valid bytes of each lane, 24 of 32 stored bytes are valid
+			const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+			for( ; i + 11 <= pixels; i += 8 ) {
+				__m256i v = _mm256_loadu_si256((const __m256i*)(src + 4 * i));
+				v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, mask), compact);
+				_mm256_storeu_si256((__m256i*)(dst + 3 * i), v);
+			}
+		}
+		SwzSSSE3(src + 4 * i, dst + pattern.m_channels * i, pixels - i, pattern);
+	}
+
+#endif
+
+	//---------------------------------------------------------------------------------------------
+
+	/// @brief Copy pixels from src to dst while reordering channels. dst may equal src, but must not overlap it otherwise.
+	inline void SwzSwizzle(const void* src, void* dst, size_t pixels, const SwizzlePattern& pattern, SwizzleIsa isa = SwzBestIsa()) {
+		auto s = (const uint8_t*)src;
+		auto d = (uint8_t*)dst;
+		switch( isa ) {
+		#ifdef VVH_SWIZZLE_X86
+			case SwizzleIsa::AVX2: 	SwzAVX2(s, d, pixels, pattern); return;
+			case SwizzleIsa::SSSE3: SwzSSSE3(s, d, pixels, pattern); return;
+		#endif
+			default: 				SwzScalar(s, d, pixels, pattern); return;
+		}
+	}
+
+} // namespace vvh
+
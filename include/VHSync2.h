@@ -9,17 +9,19 @@ namespace vvh {
 		const VkDevice& 		m_device;
 		const size_t& 			m_size; 
 		std::vector<VkFence>& 	m_fences;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = SynCreateFenceInfo>	
 	void SynCreateFences(T&& info) {
+		VVH_ZONE_FUNCTION;
 		for( int i = 0; i < info.m_size; ++i ) {
 			VkFence fence;
 			VkFenceCreateInfo fenceInfo{};
 			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 			fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-			if (vkCreateFence(info.m_device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+			if (vkCreateFence(info.m_device, &fenceInfo, info.m_pAllocator, &fence) != VK_SUCCESS) {
 				throw std::runtime_error("failed to create synchronization objects for a frame!");
 			}
 			info.m_fences.push_back(fence);
@@ -31,12 +33,14 @@ namespace vvh {
 	struct SynDestroyFencesInfo {
 		const VkDevice& m_device;
 		std::vector<VkFence>& m_fences;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = SynDestroyFencesInfo>
 	void SynDestroyFences(T&& info) {
+		VVH_ZONE_FUNCTION;
 		for( int i = 0; i < info.m_fences.size(); ++i ) {
-			vkDestroyFence(info.m_device, info.m_fences[i], nullptr);
+			vkDestroyFence(info.m_device, info.m_fences[i], info.m_pAllocator);
 		}
 	}
 
@@ -48,6 +52,7 @@ namespace vvh {
 		std::vector<VkSemaphore>& 	m_renderFinishedSemaphores; 
 		const size_t& 				m_size;
 		std::vector<Semaphores>& 	m_intermediateSemaphores;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = SynCreateSemaphoresInfo>
@@ -60,7 +65,7 @@ namespace vvh {
 			Semaphores Sem;
 			for (size_t j = 0; j < MAX_FRAMES_IN_FLIGHT; j++) {
 				VkSemaphore semaphore;
-				if (vkCreateSemaphore(info.m_device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS != VK_SUCCESS) {
+				if (vkCreateSemaphore(info.m_device, &semaphoreInfo, info.m_pAllocator, &semaphore) != VK_SUCCESS != VK_SUCCESS) {
 					throw std::runtime_error("failed to create synchronization objects for a frame!");
 				}
 				Sem.m_renderFinishedSemaphores.push_back(semaphore);
@@ -70,7 +75,7 @@ namespace vvh {
 
 		for (size_t j = info.m_imageAvailableSemaphores.size(); j < MAX_FRAMES_IN_FLIGHT; j++) {
 			VkSemaphore semaphore;
-			if (vkCreateSemaphore(info.m_device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS ) {
+			if (vkCreateSemaphore(info.m_device, &semaphoreInfo, info.m_pAllocator, &semaphore) != VK_SUCCESS ) {
 				throw std::runtime_error("failed to create synchronization objects for a frame!");
 			}
 			info.m_imageAvailableSemaphores.push_back(semaphore);
@@ -78,7 +83,7 @@ namespace vvh {
 
 		for (size_t j = info.m_renderFinishedSemaphores.size(); j < MAX_FRAMES_IN_FLIGHT; j++) {
 			VkSemaphore semaphore;
-			if (vkCreateSemaphore(info.m_device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS ) {
+			if (vkCreateSemaphore(info.m_device, &semaphoreInfo, info.m_pAllocator, &semaphore) != VK_SUCCESS ) {
 				throw std::runtime_error("failed to create synchronization objects for a frame!");
 			}
 			info.m_renderFinishedSemaphores.push_back(semaphore);
@@ -92,22 +97,24 @@ namespace vvh {
 		std::vector<VkSemaphore>& m_imageAvailableSemaphores;
 		std::vector<VkSemaphore>& m_renderFinishedSemaphores; 
 		std::vector<Semaphores>& m_intermediateSemaphores;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
 	};
 
 	template<typename T = SynDestroySemaphoresInfo>
    	void SynDestroySemaphores(T&& info) {
+		VVH_ZONE_FUNCTION;
 
 		for( auto Sem : info.m_intermediateSemaphores ) {
 			for ( auto sem : Sem.m_renderFinishedSemaphores ) {
-				vkDestroySemaphore(info.m_device, sem, nullptr);
+				vkDestroySemaphore(info.m_device, sem, info.m_pAllocator);
 			}
 		}
 
 		for ( auto sem : info.m_imageAvailableSemaphores) {
-			vkDestroySemaphore(info.m_device, sem, nullptr);
+			vkDestroySemaphore(info.m_device, sem, info.m_pAllocator);
 		}
 		for ( auto sem : info.m_renderFinishedSemaphores) {
-			vkDestroySemaphore(info.m_device, sem, nullptr);
+			vkDestroySemaphore(info.m_device, sem, info.m_pAllocator);
 		}
 	}
 
@@ -0,0 +1,455 @@
+#pragma once
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Block compressed textures from KTX2 and DDS containers.
+	// All mip levels and layers are uploaded with a single multi-region vkCmdCopyBufferToImage.
+
+	struct ImgBlockInfo {
+		uint32_t m_blockWidth{0};
+		uint32_t m_blockHeight{0};
+		uint32_t m_blockBytes{0};
+	};
+
+	inline auto ImgFormatBlockInfo(VkFormat format) -> ImgBlockInfo {
+		if( format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK ) {
+			//ASTC formats come in UNORM/SRGB pairs ordered by block size
+			static const uint32_t dims[14][2] = { {4,4}, {5,4}, {5,5}, {6,5}, {6,6}, {8,5}, {8,6}, {8,8},
+				{10,5}, {10,6}, {10,8}, {10,10}, {12,10}, {12,12} };
+			auto& d = dims[(format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+			return { d[0], d[1], 16 };
+		}
+
+		switch( format ) {
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK: case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			case VK_FORMAT_BC4_UNORM_BLOCK: case VK_FORMAT_BC4_SNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK: case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+			case VK_FORMAT_EAC_R11_UNORM_BLOCK: case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+				return { 4, 4, 8 };
+			case VK_FORMAT_BC2_UNORM_BLOCK: case VK_FORMAT_BC2_SRGB_BLOCK:
+			case VK_FORMAT_BC3_UNORM_BLOCK: case VK_FORMAT_BC3_SRGB_BLOCK:
+			case VK_FORMAT_BC5_UNORM_BLOCK: case VK_FORMAT_BC5_SNORM_BLOCK:
+			case VK_FORMAT_BC6H_UFLOAT_BLOCK: case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+			case VK_FORMAT_BC7_UNORM_BLOCK: case VK_FORMAT_BC7_SRGB_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+			case VK_FORMAT_EAC_R11G11_UNORM_BLOCK: case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+				return { 4, 4, 16 };
+			case VK_FORMAT_R8_UNORM: case VK_FORMAT_R8_SNORM: case VK_FORMAT_R8_UINT: case VK_FORMAT_R8_SRGB:
+				return { 1, 1, 1 };
+			case VK_FORMAT_R8G8_UNORM: case VK_FORMAT_R8G8_SNORM: case VK_FORMAT_R8G8_UINT: case VK_FORMAT_R8G8_SRGB:
+			case VK_FORMAT_R16_UNORM: case VK_FORMAT_R16_SFLOAT: case VK_FORMAT_R16_UINT:
+				return { 1, 1, 2 };
+			case VK_FORMAT_R8G8B8A8_UNORM: case VK_FORMAT_R8G8B8A8_SNORM: case VK_FORMAT_R8G8B8A8_UINT: case VK_FORMAT_R8G8B8A8_SRGB:
+			case VK_FORMAT_B8G8R8A8_UNORM: case VK_FORMAT_B8G8R8A8_SRGB:
+			case VK_FORMAT_A2B10G10R10_UNORM_PACK32: case VK_FORMAT_B10G11R11_UFLOAT_PACK32: case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+			case VK_FORMAT_R16G16_UNORM: case VK_FORMAT_R16G16_SFLOAT: case VK_FORMAT_R32_SFLOAT: case VK_FORMAT_R32_UINT:
+				return { 1, 1, 4 };
+			case VK_FORMAT_R16G16B16A16_UNORM: case VK_FORMAT_R16G16B16A16_SFLOAT: case VK_FORMAT_R32G32_SFLOAT:
+				return { 1, 1, 8 };
+			case VK_FORMAT_R32G32B32A32_SFLOAT: case VK_FORMAT_R32G32B32A32_UINT:
+				return { 1, 1, 16 };
+			default:
+				return {};
+		}
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	/// @brief Returns the sRGB variant of a UNORM format or vice versa, VK_FORMAT_UNDEFINED if there is none.
+	inline auto ImgSrgbCounterpart(VkFormat format) -> VkFormat {
+		static const VkFormat pairs[][2] = {
+			{ VK_FORMAT_R8G8B8A8_UNORM, 			VK_FORMAT_R8G8B8A8_SRGB },
+			{ VK_FORMAT_B8G8R8A8_UNORM, 			VK_FORMAT_B8G8R8A8_SRGB },
+			{ VK_FORMAT_BC1_RGB_UNORM_BLOCK, 		VK_FORMAT_BC1_RGB_SRGB_BLOCK },
+			{ VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 		VK_FORMAT_BC1_RGBA_SRGB_BLOCK },
+			{ VK_FORMAT_BC2_UNORM_BLOCK, 			VK_FORMAT_BC2_SRGB_BLOCK },
+			{ VK_FORMAT_BC3_UNORM_BLOCK, 			VK_FORMAT_BC3_SRGB_BLOCK },
+			{ VK_FORMAT_BC7_UNORM_BLOCK, 			VK_FORMAT_BC7_SRGB_BLOCK },
+			{ VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, 	VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK },
+			{ VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, 	VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK },
+			{ VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, 	VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK },
+		};
+		for( auto& p : pairs ) {
+			if( p[0] == format ) return p[1];
+			if( p[1] == format ) return p[0];
+		}
+		if( format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK ) {
+			bool isUnorm = ((format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) & 1) == 0;
+			return (VkFormat)(isUnorm ? format + 1 : format - 1);
+		}
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	/// @brief Fill m_regions, assuming each (mip level, layer) image is tightly packed.
+	/// offsetOf(level, layer) returns the byte offset of that image relative to m_data.
+	template<typename F>
+	inline void ImgComputeTextureRegions(TextureData& tex, F&& offsetOf) {
+		tex.m_regions.clear();
+		for( uint32_t level = 0; level < tex.m_mipLevels; ++level ) {
+			for( uint32_t layer = 0; layer < tex.m_layers * tex.m_faces; ++layer ) {
+				VkBufferImageCopy region{};
+				region.bufferOffset = offsetOf(level, layer);
+				region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, layer, 1 };
+				region.imageExtent = { std::max(1u, tex.m_width >> level), std::max(1u, tex.m_height >> level), std::max(1u, tex.m_depth >> level) };
+				tex.m_regions.push_back(region);
+			}
+		}
+	}
+
+	inline auto ImgLevelSize(const TextureData& tex, uint32_t level) -> size_t {
+		auto block = ImgFormatBlockInfo(tex.m_format);
+		size_t w = std::max(1u, tex.m_width >> level), h = std::max(1u, tex.m_height >> level), d = std::max(1u, tex.m_depth >> level);
+		return ((w + block.m_blockWidth - 1) / block.m_blockWidth) * ((h + block.m_blockHeight - 1) / block.m_blockHeight) * d * block.m_blockBytes;
+	}
+
+	/// @brief Throw if a region reads past the end of m_data. Call before copying the regions.
+	inline void ImgCheckTextureRegions(const TextureData& tex) {
+		for( auto& region : tex.m_regions ) {
+			size_t bytes = ImgLevelSize(tex, region.imageSubresource.mipLevel);
+			if( region.bufferOffset > tex.m_size || bytes > tex.m_size - region.bufferOffset ) {
+				throw std::runtime_error("texture region exceeds the file!");
+			}
+		}
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	/// @brief Parse a KTX2 container. Returns false if the data is not KTX2.
+	/// Supercompressed (Zstd, Basis) files and volume textures are not supported.
+	inline bool ImgParseKTX2(const void* data, size_t size, TextureData& tex) {
+		static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+		struct Header {
+			uint8_t  identifier[12];
+			uint32_t vkFormat, typeSize, pixelWidth, pixelHeight, pixelDepth, layerCount, faceCount, levelCount, supercompressionScheme;
+			uint32_t dfdByteOffset, dfdByteLength, kvdByteOffset, kvdByteLength;
+			uint64_t sgdByteOffset, sgdByteLength;
+		};
+		struct LevelIndex { uint64_t byteOffset, byteLength, uncompressedByteLength; };
+
+		if( size < sizeof(Header) || memcmp(data, identifier, sizeof(identifier)) != 0 ) return false;
+		Header header;
+		memcpy(&header, data, sizeof(Header));
+
+		if( header.supercompressionScheme != 0 ) throw std::runtime_error("KTX2: supercompressed files are not supported!");
+		if( header.vkFormat == VK_FORMAT_UNDEFINED ) throw std::runtime_error("KTX2: Basis Universal files are not supported!");
+		if( header.pixelDepth > 1 ) throw std::runtime_error("KTX2: volume textures are not supported!");
+
+		tex.m_format 	= (VkFormat)header.vkFormat;
+		tex.m_width 	= header.pixelWidth;
+		tex.m_height 	= std::max(1u, header.pixelHeight);
+		tex.m_depth 	= 1;
+		tex.m_layers 	= std::max(1u, header.layerCount);
+		tex.m_faces 	= std::max(1u, header.faceCount);
+		tex.m_mipLevels = std::max(1u, header.levelCount);
+		tex.m_data 		= (const uint8_t*)data;
+		tex.m_size 		= size;
+
+		if( ImgFormatBlockInfo(tex.m_format).m_blockBytes == 0 ) throw std::runtime_error("KTX2: unsupported format!");
+		if( sizeof(Header) + tex.m_mipLevels * sizeof(LevelIndex) > size ) throw std::runtime_error("KTX2: truncated file!");
+
+		std::vector<LevelIndex> levels(tex.m_mipLevels);
+		memcpy(levels.data(), (const uint8_t*)data + sizeof(Header), levels.size() * sizeof(LevelIndex));
+		for( uint32_t i = 0; i < tex.m_mipLevels; ++i ) {
+			auto& level = levels[i];
+			if( level.byteOffset > size || level.byteLength > size - level.byteOffset ) throw std::runtime_error("KTX2: truncated file!");
+			if( (uint64_t)tex.m_layers * tex.m_faces * ImgLevelSize(tex, i) > level.byteLength ) throw std::runtime_error("KTX2: level is smaller than its images!");
+		}
+
+		//within a level, images are ordered by layer, then face
+		ImgComputeTextureRegions(tex, [&](uint32_t level, uint32_t layer) -> VkDeviceSize {
+			return levels[level].byteOffset + layer * ImgLevelSize(tex, level);
+		});
+		return true;
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	inline auto ImgDxgiToVkFormat(uint32_t dxgiFormat) -> VkFormat {
+		switch( dxgiFormat ) {
+			case 2:  return VK_FORMAT_R32G32B32A32_SFLOAT;
+			case 10: return VK_FORMAT_R16G16B16A16_SFLOAT;
+			case 11: return VK_FORMAT_R16G16B16A16_UNORM;
+			case 24: return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+			case 26: return VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+			case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+			case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+			case 34: return VK_FORMAT_R16G16_SFLOAT;
+			case 41: return VK_FORMAT_R32_SFLOAT;
+			case 49: return VK_FORMAT_R8G8_UNORM;
+			case 54: return VK_FORMAT_R16_SFLOAT;
+			case 61: return VK_FORMAT_R8_UNORM;
+			case 67: return VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+			case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+			case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+			case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+			case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+			case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+			case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+			case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+			case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+			case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+			case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+			case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+			case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+			case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+			case 96: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+			case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+			case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+			default: return VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	/// @brief Parse a DDS file. Returns false if the data is not DDS.
+	/// Legacy files without DX10 header carry no color space, they are loaded as sRGB if srgb is true.
+	/// Volume textures are not supported.
+	inline bool ImgParseDDS(const void* data, size_t size, bool srgb, TextureData& tex) {
+		struct PixelFormat { uint32_t size, flags, fourCC, rgbBitCount, rMask, gMask, bMask, aMask; };
+		struct Header {
+			uint32_t magic, size, flags, height, width, pitchOrLinearSize, depth, mipMapCount, reserved1[11];
+			PixelFormat pf;
+			uint32_t caps, caps2, caps3, caps4, reserved2;
+		};
+		struct HeaderDX10 { uint32_t dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2; };
+
+		auto fourCC = [](const char* s) { return (uint32_t)s[0] | ((uint32_t)s[1] << 8) | ((uint32_t)s[2] << 16) | ((uint32_t)s[3] << 24); };
+		const uint32_t DDPF_FOURCC = 0x4, DDPF_RGB = 0x40, DDSCAPS2_CUBEMAP = 0x200, DDSCAPS2_VOLUME = 0x200000, DX10_MISC_TEXTURECUBE = 0x4;
+		const uint32_t DX10_DIMENSION_TEXTURE3D = 4;
+
+		if( size < sizeof(Header) || *(const uint32_t*)data != fourCC("DDS ") ) return false;
+		Header header;
+		memcpy(&header, data, sizeof(Header));
+		size_t offset = sizeof(Header);
+		if( (header.caps2 & DDSCAPS2_VOLUME) && header.depth > 1 ) throw std::runtime_error("DDS: volume textures are not supported!");
+
+		tex.m_width 	= header.width;
+		tex.m_height 	= std::max(1u, header.height);
+		tex.m_depth 	= 1;
+		tex.m_mipLevels = std::max(1u, header.mipMapCount);
+		tex.m_layers 	= 1;
+		tex.m_faces 	= (header.caps2 & DDSCAPS2_CUBEMAP) ? 6 : 1;
+		tex.m_format 	= VK_FORMAT_UNDEFINED;
+
+		if( (header.pf.flags & DDPF_FOURCC) && header.pf.fourCC == fourCC("DX10") ) {
+			if( size < offset + sizeof(HeaderDX10) ) throw std::runtime_error("DDS: truncated file!");
+			HeaderDX10 dx10;
+			memcpy(&dx10, (const uint8_t*)data + offset, sizeof(HeaderDX10));
+			offset += sizeof(HeaderDX10);
+			if( dx10.resourceDimension == DX10_DIMENSION_TEXTURE3D && header.depth > 1 ) throw std::runtime_error("DDS: volume textures are not supported!");
+			tex.m_format = ImgDxgiToVkFormat(dx10.dxgiFormat);
+			tex.m_layers = std::max(1u, dx10.arraySize);
+			if( dx10.miscFlag & DX10_MISC_TEXTURECUBE ) tex.m_faces = 6;
+		} else if( header.pf.flags & DDPF_FOURCC ) {
+			uint32_t cc = header.pf.fourCC;
+			if( cc == fourCC("DXT1") ) 									tex.m_format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+			else if( cc == fourCC("DXT2") || cc == fourCC("DXT3") ) 	tex.m_format = VK_FORMAT_BC2_UNORM_BLOCK;
+			else if( cc == fourCC("DXT4") || cc == fourCC("DXT5") ) 	tex.m_format = VK_FORMAT_BC3_UNORM_BLOCK;
+			else if( cc == fourCC("ATI1") || cc == fourCC("BC4U") ) 	tex.m_format = VK_FORMAT_BC4_UNORM_BLOCK;
+			else if( cc == fourCC("BC4S") ) 							tex.m_format = VK_FORMAT_BC4_SNORM_BLOCK;
+			else if( cc == fourCC("ATI2") || cc == fourCC("BC5U") ) 	tex.m_format = VK_FORMAT_BC5_UNORM_BLOCK;
+			else if( cc == fourCC("BC5S") ) 							tex.m_format = VK_FORMAT_BC5_SNORM_BLOCK;
+			if( srgb && ImgSrgbCounterpart(tex.m_format) != VK_FORMAT_UNDEFINED ) tex.m_format = ImgSrgbCounterpart(tex.m_format);
+		} else if( (header.pf.flags & DDPF_RGB) && header.pf.rgbBitCount == 32 ) {
+			if( header.pf.rMask == 0x000000ff ) tex.m_format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+			else if( header.pf.rMask == 0x00ff0000 ) tex.m_format = srgb ? VK_FORMAT_B8G8R8A8_SRGB : VK_FORMAT_B8G8R8A8_UNORM;
+		}
+
+		if( tex.m_format == VK_FORMAT_UNDEFINED ) throw std::runtime_error("DDS: unsupported format!");
+
+		tex.m_data = (const uint8_t*)data;
+		tex.m_size = size;
+
+		//DDS stores all mip levels of a layer/face before the next one
+		size_t layerSize = 0;
+		for( uint32_t level = 0; level < tex.m_mipLevels; ++level ) layerSize += ImgLevelSize(tex, level);
+		if( offset + layerSize * tex.m_layers * tex.m_faces > size ) throw std::runtime_error("DDS: truncated file!");
+
+		ImgComputeTextureRegions(tex, [&](uint32_t level, uint32_t layer) -> VkDeviceSize {
+			size_t off = offset + layer * layerSize;
+			for( uint32_t l = 0; l < level; ++l ) off += ImgLevelSize(tex, l);
+			return off;
+		});
+		return true;
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	/// @brief Load a KTX2 or DDS file into tex. The file is memory mapped and kept open in tex.m_file.
+	inline void ImgLoadTextureFile(const std::string& filename, bool srgb, TextureData& tex) {
+		tex.m_file.Open(filename);
+		const void* data = tex.m_file.Data();
+		size_t size = tex.m_file.Size();
+		if( !ImgParseKTX2(data, size, tex) && !ImgParseDDS(data, size, srgb, tex) ) {
+			throw std::runtime_error("unknown texture container: " + filename);
+		}
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	struct ImgSelectTextureFormatInfo {
+		const VkPhysicalDevice& m_physicalDevice;
+		TextureData& 			m_textureData;
+		bool 					m_allowSrgbSwap{false};	//fall back to the sRGB/UNORM counterpart, changes how texels decode
+	};
+
+	/// @brief Make sure the device can sample the texture format with optimal tiling. Throws if it cannot, e.g.
+	/// BC on mobile or ASTC/ETC2 on desktop GPUs. In that case the caller should load a different encoding.
+	/// With m_allowSrgbSwap the sRGB/UNORM counterpart is tried first, the shader then sees other color values.
+	template<typename T = ImgSelectTextureFormatInfo>
+	inline auto ImgSelectTextureFormat(T&& info) -> VkFormat {
+		VVH_ZONE_FUNCTION;
+		auto supported = [&](VkFormat format) {
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(info.m_physicalDevice, format, &props);
+			return (props.optimalTilingFeatures & (VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT))
+				== (VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT);
+		};
+
+		if( supported(info.m_textureData.m_format) ) return info.m_textureData.m_format;
+		VkFormat other = info.m_allowSrgbSwap ? ImgSrgbCounterpart(info.m_textureData.m_format) : VK_FORMAT_UNDEFINED;
+		if( other != VK_FORMAT_UNDEFINED && supported(other) ) return info.m_textureData.m_format = other;
+		throw std::runtime_error("texture format not supported by the device!");
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	/// @brief Of a list of encodings the same asset is available in, return the first one the device can sample.
+	inline auto ImgPickTextureFormat(VkPhysicalDevice physicalDevice, const std::vector<VkFormat>& candidates) -> VkFormat {
+		return RenFindSupportedFormat({
+			.m_physicalDevice 	= physicalDevice,
+			.m_candidates 		= candidates,
+			.m_tiling 			= VK_IMAGE_TILING_OPTIMAL,
+			.m_features 		= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT
+		});
+	}
+
+	//---------------------------------------------------------------------------------------------
+
+	struct ImgCreateTextureImageFromDataInfo {
+		const VkPhysicalDevice& m_physicalDevice;
+		const VkDevice& 		m_device;
+		const VmaAllocator& 	m_vmaAllocator;
+		const VkQueue& 			m_graphicsQueue;
+		const VkCommandPool& 	m_commandPool;
+		TextureData& 			m_textureData;
+		Image& 					m_texture;
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+	};
+
+	/// @brief Create a sampled image and view from TextureData. Mip levels are taken from the file, not generated.
+	template<typename T = ImgCreateTextureImageFromDataInfo>
+	inline void ImgCreateTextureImageFromData(T&& info) {
+		VVH_ZONE_FUNCTION;
+		auto& tex = info.m_textureData;
+		VkFormat format = ImgSelectTextureFormat({ info.m_physicalDevice, tex });
+		uint32_t layers = tex.m_layers * tex.m_faces;
+
+		//pack the regions into the staging buffer, file offsets need not be aligned to the block size (e.g. DDS)
+		ImgCheckTextureRegions(tex);
+		std::vector<VkBufferImageCopy> regions = tex.m_regions;
+		VkDeviceSize size = 0;
+		for( auto& region : regions ) {
+			size = (size + 15) & ~(VkDeviceSize)15;
+			size += ImgLevelSize(tex, region.imageSubresource.mipLevel);
+		}
+
+		VkBuffer stagingBuffer;
+		VmaAllocation stagingBufferAllocation;
+		VmaAllocationInfo allocInfo;
+		BufCreateBuffer( {
+			.m_vmaAllocator 	= info.m_vmaAllocator,
+			.m_size 			= size,
+			.m_usageFlags 		= VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			.m_properties 		= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			.m_vmaFlags 		= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+			.m_buffer 			= stagingBuffer,
+			.m_allocation 		= stagingBufferAllocation,
+			.m_allocationInfo 	= &allocInfo
+		});
+		VkDeviceSize offset = 0;
+		for( auto& region : regions ) {
+			offset = (offset + 15) & ~(VkDeviceSize)15;
+			size_t bytes = ImgLevelSize(tex, region.imageSubresource.mipLevel);
+			memcpy((uint8_t*)allocInfo.pMappedData + offset, tex.m_data + region.bufferOffset, bytes);
+			region.bufferOffset = offset;
+			offset += bytes;
+		}
+
+		ImgCreateImage({
+			.m_physicalDevice 	= info.m_physicalDevice,
+			.m_device 			= info.m_device,
+			.m_vmaAllocator 	= info.m_vmaAllocator,
+			.m_width 			= tex.m_width,
+			.m_height 			= tex.m_height,
+			.m_depth 			= 1,
+			.m_layers 			= layers,
+			.m_mipLevels 		= tex.m_mipLevels,
+			.m_format 			= format,
+			.m_tiling 			= VK_IMAGE_TILING_OPTIMAL,
+			.m_usage 			= VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			.m_imageLayout 		= VK_IMAGE_LAYOUT_UNDEFINED,
+			.m_properties 		= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			.m_image 			= info.m_texture.m_mapImage,
+			.m_imageAllocation 	= info.m_texture.m_mapImageAllocation,
+			.m_flags 			= tex.m_faces == 6 ? (VkImageCreateFlags)VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : (VkImageCreateFlags)0
+		});
+
+		VkCommandBuffer commandBuffer = ComBeginSingleTimeCommands(info);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = info.m_texture.m_mapImage;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, tex.m_mipLevels, 0, layers };
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &barrier);
+
+		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, info.m_texture.m_mapImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			(uint32_t)regions.size(), regions.data());
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &barrier);
+
+		ComEndSingleTimeCommands({info.m_device, info.m_graphicsQueue, info.m_commandPool, commandBuffer});
+		BufDestroyBuffer({info.m_device, info.m_vmaAllocator, stagingBuffer, stagingBufferAllocation});
+
+		VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D;
+		if( tex.m_faces == 6 ) viewType = tex.m_layers > 1 ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+		else if( tex.m_layers > 1 ) viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+
+		info.m_texture.m_mapImageView = ImgCreateImageView({
+			.m_device 		= info.m_device,
+			.m_image 		= info.m_texture.m_mapImage,
+			.m_format 		= format,
+			.m_aspects 		= VK_IMAGE_ASPECT_COLOR_BIT,
+			.m_layers 		= layers,
+			.m_mipLevels 	= tex.m_mipLevels,
+			.m_viewType 	= viewType,
+			.m_pAllocator 	= info.m_pAllocator
+		});
+
+		info.m_texture.m_width 		= (int)tex.m_width;
+		info.m_texture.m_height 	= (int)tex.m_height;
+		info.m_texture.m_layers 	= (int)layers;
+		info.m_texture.m_mipLevels 	= tex.m_mipLevels;
+		info.m_texture.m_size 		= size;
+	}
+
+} // namespace vh
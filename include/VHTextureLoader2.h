@@ -0,0 +1,657 @@
+#pragma once
+
+#include <deque>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Texture loading service. Files are decoded on a thread pool, straight from the memory mapped file.
+	// The workers write the pixels into slices of one persistently mapped staging ring. If the ring is full, a worker
+	// keeps the pixels in memory instead of waiting, and Update() stages them once uploads have freed space.
+	// Update() records the uploads of all decoded textures into one command buffer per frame and submits it.
+	// A handle becomes ready, with a valid image view and sampler, once its batch's fence has signaled.
+	// Until then GetDescriptor() returns a 1x1 white placeholder, so descriptors can be written right after Load().
+	// Load(), Update() and the queries are meant for the thread that owns the queue.
+
+	class TextureLoader {
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle c_invalidHandle = ~0u;
+		enum class State { Loading, Ready, Failed };
+
+		struct Statistics {
+			uint64_t 	m_requested{0};
+			uint64_t 	m_decoded{0};
+			uint64_t 	m_failed{0};
+			uint64_t 	m_stagedBytes{0};
+			uint64_t 	m_batches{0};
+			uint64_t 	m_maxBatchSize{0};
+			uint64_t 	m_deferred{0};			//decoded while the ring was full, staged later by Update()
+			double 		m_decodeSeconds{0};		//summed over all workers
+		};
+
+		explicit TextureLoader(ThreadPool& threadPool) : m_threadPool{threadPool} {}
+		~TextureLoader() { assert(m_device == VK_NULL_HANDLE && "call Destroy() before destroying the device"); }
+
+		void Init(VkPhysicalDevice physicalDevice, VkDevice device, VmaAllocator vmaAllocator, VkQueue queue, uint32_t queueFamily,
+				SamplerCache& samplerCache, VkDeviceSize stagingSize = 64 << 20, const VkAllocationCallbacks* pAllocator = nullptr) {
+			m_physicalDevice = physicalDevice;
+			m_device = device;
+			m_vmaAllocator = vmaAllocator;
+			m_queue = queue;
+			m_samplerCache = &samplerCache;
+			m_pAllocator = pAllocator;
+
+			const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT
+				| VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, VK_FORMAT_R8G8B8A8_SRGB, &props);
+			m_blitSrgb = (props.optimalTilingFeatures & blitFeatures) == blitFeatures;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, VK_FORMAT_R8G8B8A8_UNORM, &props);
+			m_blitUnorm = (props.optimalTilingFeatures & blitFeatures) == blitFeatures;
+
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			poolInfo.queueFamilyIndex = queueFamily;
+			if (vkCreateCommandPool(device, &poolInfo, pAllocator, &m_commandPool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create texture loader command pool!");
+			}
+
+			VmaAllocationInfo allocInfo;
+			BufCreateBuffer( {
+				.m_vmaAllocator 	= vmaAllocator,
+				.m_size 			= stagingSize,
+				.m_usageFlags 		= VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				.m_properties 		= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				.m_vmaFlags 		= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+				.m_buffer 			= m_ring.m_buffer,
+				.m_allocation 		= m_ring.m_allocation,
+				.m_allocationInfo 	= &allocInfo
+			});
+			m_ring.m_mapped = (uint8_t*)allocInfo.pMappedData;
+			m_ring.m_capacity = stagingSize;
+
+			CreatePlaceholder();
+		}
+
+		/// @brief Wait for all loads, then free all textures and the staging ring.
+		void Destroy() {
+			if( m_device == VK_NULL_HANDLE ) return;
+			WaitIdle();
+			for( auto& texture : m_textures ) {
+				if( texture.m_state != State::Ready ) continue;
+				m_samplerCache->Release(texture.m_image.m_mapSampler);
+				vkDestroyImageView(m_device, texture.m_image.m_mapImageView, m_pAllocator);
+				ImgDestroyImage({m_device, m_vmaAllocator, texture.m_image.m_mapImage, texture.m_image.m_mapImageAllocation});
+			}
+			m_textures.clear();
+			m_samplerCache->Release(m_placeholder.m_mapSampler);
+			vkDestroyImageView(m_device, m_placeholder.m_mapImageView, m_pAllocator);
+			ImgDestroyImage({m_device, m_vmaAllocator, m_placeholder.m_mapImage, m_placeholder.m_mapImageAllocation});
+			BufDestroyBuffer({m_device, m_vmaAllocator, m_ring.m_buffer, m_ring.m_allocation});
+			vkDestroyCommandPool(m_device, m_commandPool, m_pAllocator);
+			m_device = VK_NULL_HANDLE;
+		}
+
+		/// @brief Start loading a KTX2, DDS or any stb_image file. 8 bit images get a full mip chain.
+		auto Load(const std::string& filename, bool srgb = true) -> Handle {
+			Handle handle = (Handle)m_textures.size();
+			m_textures.emplace_back();
+			m_textures.back().m_name = filename;
+			++m_outstanding;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				++m_statistics.m_requested;
+			}
+			m_threadPool.Enqueue([this, handle, filename, srgb] { Decode(handle, filename, srgb); });
+			return handle;
+		}
+
+		/// @brief Call once per frame. Makes textures of completed uploads ready and submits the uploads of
+		/// all textures decoded since the last call. Returns the number of textures that became ready.
+		auto Update() -> uint32_t {
+			uint32_t ready = Retire();
+			Submit();
+			return ready;
+		}
+
+		/// @brief Block until all requested textures are ready or failed, e.g. behind a loading screen.
+		void WaitIdle() {
+			while( m_outstanding > 0 || !m_batches.empty() ) {
+				Update();
+				if( !m_batches.empty() ) {
+					vkWaitForFences(m_device, 1, &m_batches.front().m_fence, VK_TRUE, UINT64_MAX);
+				} else if( m_outstanding > 0 && m_deferred.empty() ) {
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_decodedCondition.wait(lock, [this] { return !m_decoded.empty(); });
+				}
+			}
+		}
+
+		auto GetState(Handle handle) const -> State { return m_textures[handle].m_state; }
+		bool IsReady(Handle handle) const { return m_textures[handle].m_state == State::Ready; }
+		auto GetImage(Handle handle) const -> const Image& { return m_textures[handle].m_image; }
+		auto GetError(Handle handle) const -> const std::string& { return m_textures[handle].m_error; }
+
+		/// @brief The descriptor for a combined image sampler, the placeholder until the texture is ready.
+		auto GetDescriptor(Handle handle) const -> VkDescriptorImageInfo {
+			auto& texture = m_textures[handle];
+			const Image& image = texture.m_state == State::Ready ? texture.m_image : m_placeholder;
+			return { image.m_mapSampler, image.m_mapImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		}
+
+		/// @brief The placeholder itself, e.g. for materials without a texture.
+		auto GetPlaceholder() const -> VkDescriptorImageInfo {
+			return { m_placeholder.m_mapSampler, m_placeholder.m_mapImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		}
+
+		auto GetStatistics() -> Statistics { std::lock_guard<std::mutex> lock(m_mutex); return m_statistics; }
+
+		void PrintStatistics(std::ostream& out = std::cout) {
+			Statistics s = GetStatistics();
+			out << "Texture loader:\n"
+				<< "  requested: " << s.m_requested << " decoded: " << s.m_decoded << " failed: " << s.m_failed << "\n"
+				<< "  staged: " << s.m_stagedBytes / 1e6 << " MB in " << s.m_batches << " batches, largest batch: " << s.m_maxBatchSize << "\n"
+				<< "  decode time: " << (s.m_decoded > 0 ? 1000.0 * s.m_decodeSeconds / s.m_decoded : 0.0) << " ms/texture on "
+				<< m_threadPool.Size() << " threads, deferred: " << s.m_deferred << "\n";
+		}
+
+	private:
+		struct Texture {
+			std::string m_name;
+			State 		m_state{State::Loading};
+			Image 		m_image{};
+			VkFormat 	m_format{VK_FORMAT_UNDEFINED};
+			uint32_t 	m_layers{1};
+			uint32_t 	m_faces{1};
+			std::string m_error;
+		};
+
+		/// A decoded texture waiting for upload. m_regions are relative to the start of m_buffer.
+		struct Decoded {
+			Handle 			m_handle{c_invalidHandle};
+			VkFormat 		m_format{VK_FORMAT_UNDEFINED};
+			uint32_t 		m_width{0};
+			uint32_t 		m_height{0};
+			uint32_t 		m_layers{1};
+			uint32_t 		m_faces{1};
+			uint32_t 		m_mipLevels{1};
+			bool 			m_generateMipmaps{false};
+			std::vector<VkBufferImageCopy> m_regions;
+			VkBuffer 		m_buffer{VK_NULL_HANDLE};
+			VmaAllocation 	m_dedicated{nullptr};	//own staging buffer if the texture does not fit into the ring
+			uint64_t 		m_slice{~0ull};
+			std::vector<uint8_t> m_pixels;		//the ring was full, staged by the owner thread
+			std::string 	m_error;
+		};
+
+		struct Batch {
+			VkCommandBuffer 	m_commandBuffer;
+			VkFence 			m_fence;
+			std::vector<Decoded> m_textures;
+		};
+
+		/// Ring of staging memory. Slices are released out of order, the tail only moves past released slices.
+		struct Ring {
+			struct Slice { VkDeviceSize m_offset; VkDeviceSize m_size; bool m_released; };
+			VkBuffer 			m_buffer{VK_NULL_HANDLE};
+			VmaAllocation 		m_allocation{nullptr};
+			uint8_t* 			m_mapped{nullptr};
+			VkDeviceSize 		m_capacity{0};
+			VkDeviceSize 		m_head{0};
+			std::deque<Slice> 	m_slices;
+			uint64_t 			m_firstSlice{0};	//id of m_slices.front()
+
+			bool TryAllocate(VkDeviceSize size, VkDeviceSize& offset, uint64_t& id) {
+				size = (size + 15) & ~(VkDeviceSize)15;
+				if( m_slices.empty() ) m_head = 0;
+				VkDeviceSize tail = m_slices.empty() ? 0 : m_slices.front().m_offset;
+				if( m_slices.empty() || m_head > tail ) {
+					if( m_head + size <= m_capacity ) offset = m_head;
+					else if( size < tail ) offset = 0;		//wrap around
+					else return false;
+				} else if( m_head + size < tail ) {
+					offset = m_head;
+				} else return false;
+				m_head = offset + size;
+				id = m_firstSlice + m_slices.size();
+				m_slices.push_back({ offset, size, false });
+				return true;
+			}
+
+			void Release(uint64_t id) {
+				m_slices[id - m_firstSlice].m_released = true;
+				while( !m_slices.empty() && m_slices.front().m_released ) {
+					m_slices.pop_front();
+					++m_firstSlice;
+				}
+			}
+		};
+
+		/// Create the 1x1 white texture that stands in for textures that are not ready, cleared on the queue.
+		void CreatePlaceholder() {
+			const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+			ImgCreateImage({
+				.m_physicalDevice 	= m_physicalDevice,
+				.m_device 			= m_device,
+				.m_vmaAllocator 	= m_vmaAllocator,
+				.m_width 			= 1,
+				.m_height 			= 1,
+				.m_depth 			= 1,
+				.m_layers 			= 1,
+				.m_mipLevels 		= 1,
+				.m_format 			= format,
+				.m_tiling 			= VK_IMAGE_TILING_OPTIMAL,
+				.m_usage 			= VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				.m_imageLayout 		= VK_IMAGE_LAYOUT_UNDEFINED,
+				.m_properties 		= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				.m_image 			= m_placeholder.m_mapImage,
+				.m_imageAllocation 	= m_placeholder.m_mapImageAllocation
+			});
+
+			VkCommandBuffer commandBuffer = ComBeginSingleTimeCommands({m_device, m_commandPool});
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = m_placeholder.m_mapImage;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkClearColorValue white{ { 1.0f, 1.0f, 1.0f, 1.0f } };
+			vkCmdClearColorImage(commandBuffer, m_placeholder.m_mapImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &white, 1, &barrier.subresourceRange);
+
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+				0, nullptr, 0, nullptr, 1, &barrier);
+			ComEndSingleTimeCommands({m_device, m_queue, m_commandPool, commandBuffer});
+
+			m_placeholder.m_mapImageView = ImgCreateImageView({
+				.m_device 		= m_device,
+				.m_image 		= m_placeholder.m_mapImage,
+				.m_format 		= format,
+				.m_aspects 		= VK_IMAGE_ASPECT_COLOR_BIT,
+				.m_layers 		= 1,
+				.m_mipLevels 	= 1,
+				.m_viewType 	= VK_IMAGE_VIEW_TYPE_2D,
+				.m_pAllocator 	= m_pAllocator
+			});
+			ImgCreateTextureSampler({
+				.m_physicalDevice 	= m_physicalDevice,
+				.m_device 			= m_device,
+				.m_texture 			= m_placeholder,
+				.m_pAllocator 		= m_pAllocator,
+				.m_samplerCache 	= m_samplerCache
+			});
+			m_placeholder.m_width = m_placeholder.m_height = m_placeholder.m_layers = 1;
+			m_placeholder.m_mipLevels = 1;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Worker side
+
+		/// Get staging memory for size bytes. Uses a dedicated buffer if size exceeds the ring. If the ring is full,
+		/// the memory is m_pixels and the texture is staged later by the owner thread, workers never wait.
+		auto Stage(VkDeviceSize size, Decoded& decoded) -> uint8_t* {
+			if( size > m_ring.m_capacity ) {
+				VmaAllocationInfo allocInfo;
+				BufCreateBuffer( {
+					.m_vmaAllocator 	= m_vmaAllocator,
+					.m_size 			= size,
+					.m_usageFlags 		= VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+					.m_properties 		= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					.m_vmaFlags 		= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+					.m_buffer 			= decoded.m_buffer,
+					.m_allocation 		= decoded.m_dedicated,
+					.m_allocationInfo 	= &allocInfo
+				});
+				return (uint8_t*)allocInfo.pMappedData;
+			}
+
+			if( uint8_t* dst = TryStage(size, decoded) ) return dst;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				++m_statistics.m_deferred;
+			}
+			decoded.m_pixels.resize(size);
+			return decoded.m_pixels.data();
+		}
+
+		/// Allocate a ring slice for size bytes and move the regions into it, nullptr if the ring is full.
+		auto TryStage(VkDeviceSize size, Decoded& decoded) -> uint8_t* {
+			VkDeviceSize offset;
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if( !m_ring.TryAllocate(size, offset, decoded.m_slice) ) return nullptr;
+			m_statistics.m_stagedBytes += size;
+			decoded.m_buffer = m_ring.m_buffer;
+			for( auto& region : decoded.m_regions ) region.bufferOffset += offset;
+			return m_ring.m_mapped + offset;
+		}
+
+		void Decode(Handle handle, const std::string& filename, bool srgb) {
+			auto start = std::chrono::steady_clock::now();
+			Decoded decoded;
+			decoded.m_handle = handle;
+			try {
+				FileView file(filename);
+				TextureData tex;
+				if( ImgParseKTX2(file.Data(), file.Size(), tex) || ImgParseDDS(file.Data(), file.Size(), srgb, tex) ) {
+					if( tex.m_regions.empty() || tex.m_width == 0 ) throw std::runtime_error("texture " + filename + " contains no images!");
+					ImgCheckTextureRegions(tex);
+					decoded.m_format = ImgSelectTextureFormat({ m_physicalDevice, tex });
+					decoded.m_width = tex.m_width;
+					decoded.m_height = tex.m_height;
+					decoded.m_layers = tex.m_layers;
+					decoded.m_faces = tex.m_faces;
+					decoded.m_mipLevels = tex.m_mipLevels;
+					decoded.m_regions = tex.m_regions;
+
+					//pack the regions, the copies are relative to the slice until Stage() adds its offset
+					VkDeviceSize size = 0;
+					for( auto& region : decoded.m_regions ) {
+						size = (size + 15) & ~(VkDeviceSize)15;
+						region.bufferOffset = size;
+						size += ImgLevelSize(tex, region.imageSubresource.mipLevel);
+					}
+					uint8_t* dst = Stage(size, decoded);
+					VkDeviceSize base = decoded.m_regions[0].bufferOffset;
+					for( size_t i = 0; i < decoded.m_regions.size(); ++i ) {
+						memcpy(dst + (decoded.m_regions[i].bufferOffset - base), tex.m_data + tex.m_regions[i].bufferOffset,
+							ImgLevelSize(tex, tex.m_regions[i].imageSubresource.mipLevel));
+					}
+				} else {
+					int width, height, channels;
+					stbi_uc* pixels = stbi_load_from_memory(file.Data(), (int)file.Size(), &width, &height, &channels, STBI_rgb_alpha);
+					if( !pixels ) throw std::runtime_error("failed to decode " + filename + ": " + stbi_failure_reason());
+					decoded.m_format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+					decoded.m_width = (uint32_t)width;
+					decoded.m_height = (uint32_t)height;
+					decoded.m_generateMipmaps = srgb ? m_blitSrgb : m_blitUnorm;
+					decoded.m_mipLevels = decoded.m_generateMipmaps ? ImgMipLevels(decoded.m_width, decoded.m_height) : 1;
+					VkBufferImageCopy region{};
+					region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+					region.imageExtent = { decoded.m_width, decoded.m_height, 1 };
+					decoded.m_regions.push_back(region);
+					size_t size = (size_t)width * height * 4;
+					memcpy(Stage(size, decoded), pixels, size);
+					stbi_image_free(pixels);
+				}
+			} catch( std::exception& e ) {
+				decoded.m_error = e.what();
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_statistics.m_decodeSeconds += seconds;
+			if( decoded.m_error.empty() ) ++m_statistics.m_decoded;
+			else ++m_statistics.m_failed;
+			m_decoded.push_back(std::move(decoded));
+			m_decodedCondition.notify_all();
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Owner thread side
+
+		void Submit() {
+			std::vector<Decoded> pending, decoded;
+			pending.swap(m_deferred);
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				for( auto& d : m_decoded ) pending.push_back(std::move(d));
+				m_decoded.clear();
+			}
+			if( pending.empty() ) return;
+
+			//stage textures the workers could not fit into the ring, those that still do not fit wait for the next frame
+			for( auto& d : pending ) {
+				if( !d.m_pixels.empty() ) {
+					uint8_t* dst = TryStage(d.m_pixels.size(), d);
+					if( !dst ) {
+						m_deferred.push_back(std::move(d));
+						continue;
+					}
+					memcpy(dst, d.m_pixels.data(), d.m_pixels.size());
+					std::vector<uint8_t>().swap(d.m_pixels);
+				}
+				decoded.push_back(std::move(d));
+			}
+
+			//create the images first, a texture whose image cannot be created fails on its own
+			std::vector<Decoded> uploads;
+			for( auto& d : decoded ) {
+				if( d.m_error.empty() ) {
+					try {
+						CreateImage(d);
+						uploads.push_back(std::move(d));
+						continue;
+					} catch( std::exception& e ) {
+						d.m_error = e.what();
+					}
+				}
+				Fail(d);
+			}
+			if( uploads.empty() ) return;
+
+			//on an error, nothing of the batch reaches the queue and all its textures fail
+			Batch batch{};
+			auto abort = [&](const char* error) {
+				if( batch.m_fence != VK_NULL_HANDLE ) vkDestroyFence(m_device, batch.m_fence, m_pAllocator);
+				if( batch.m_commandBuffer != VK_NULL_HANDLE ) vkFreeCommandBuffers(m_device, m_commandPool, 1, &batch.m_commandBuffer);
+				for( auto& d : uploads ) {
+					auto& texture = m_textures[d.m_handle];
+					ImgDestroyImage({m_device, m_vmaAllocator, texture.m_image.m_mapImage, texture.m_image.m_mapImageAllocation});
+					texture.m_image = {};
+					d.m_error = error;
+					Fail(d);
+				}
+				throw std::runtime_error(error);
+			};
+
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = m_commandPool;
+			allocInfo.commandBufferCount = 1;
+			if (vkAllocateCommandBuffers(m_device, &allocInfo, &batch.m_commandBuffer) != VK_SUCCESS) {
+				batch.m_commandBuffer = VK_NULL_HANDLE;
+				abort("failed to allocate texture upload command buffer!");
+			}
+
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			vkBeginCommandBuffer(batch.m_commandBuffer, &beginInfo);
+
+			std::vector<VkImageMemoryBarrier> toTransfer, toShader;
+			for( auto& d : uploads ) {
+				VkImageMemoryBarrier barrier{};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = m_textures[d.m_handle].m_image.m_mapImage;
+				barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, d.m_mipLevels, 0, d.m_layers * d.m_faces };
+				barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				toTransfer.push_back(barrier);
+
+				if( !d.m_generateMipmaps ) {
+					barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+					barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+					barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+					toShader.push_back(barrier);
+				}
+			}
+
+			vkCmdPipelineBarrier(batch.m_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				0, nullptr, 0, nullptr, (uint32_t)toTransfer.size(), toTransfer.data());
+
+			for( auto& d : uploads ) {
+				auto& texture = m_textures[d.m_handle];
+				vkCmdCopyBufferToImage(batch.m_commandBuffer, d.m_buffer, texture.m_image.m_mapImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					(uint32_t)d.m_regions.size(), d.m_regions.data());
+				if( d.m_generateMipmaps ) {
+					ImgGenerateMipmaps({ batch.m_commandBuffer, texture.m_image.m_mapImage, d.m_width, d.m_height, d.m_mipLevels, 1 });
+				}
+			}
+
+			vkCmdPipelineBarrier(batch.m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+				0, nullptr, 0, nullptr, (uint32_t)toShader.size(), toShader.data());
+			if (vkEndCommandBuffer(batch.m_commandBuffer) != VK_SUCCESS) {
+				abort("failed to record texture uploads!");
+			}
+
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			if (vkCreateFence(m_device, &fenceInfo, m_pAllocator, &batch.m_fence) != VK_SUCCESS) {
+				batch.m_fence = VK_NULL_HANDLE;
+				abort("failed to create texture upload fence!");
+			}
+
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &batch.m_commandBuffer;
+			if (vkQueueSubmit(m_queue, 1, &submitInfo, batch.m_fence) != VK_SUCCESS) {
+				abort("failed to submit texture uploads!");
+			}
+
+			batch.m_textures = std::move(uploads);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_statistics.m_batches;
+			m_statistics.m_maxBatchSize = std::max(m_statistics.m_maxBatchSize, (uint64_t)batch.m_textures.size());
+			m_batches.push_back(std::move(batch));
+		}
+
+		/// Create the image of a decoded texture, it is uploaded by the batch.
+		void CreateImage(const Decoded& d) {
+			auto& texture = m_textures[d.m_handle];
+			uint32_t layers = d.m_layers * d.m_faces;
+			VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			if( d.m_generateMipmaps ) usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			VkImageCreateFlags flags = d.m_faces == 6 ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+			ImgCreateImage({
+				.m_physicalDevice 	= m_physicalDevice,
+				.m_device 			= m_device,
+				.m_vmaAllocator 	= m_vmaAllocator,
+				.m_width 			= d.m_width,
+				.m_height 			= d.m_height,
+				.m_depth 			= 1,
+				.m_layers 			= layers,
+				.m_mipLevels 		= d.m_mipLevels,
+				.m_format 			= d.m_format,
+				.m_tiling 			= VK_IMAGE_TILING_OPTIMAL,
+				.m_usage 			= usage,
+				.m_imageLayout 		= VK_IMAGE_LAYOUT_UNDEFINED,
+				.m_properties 		= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				.m_image 			= texture.m_image.m_mapImage,
+				.m_imageAllocation 	= texture.m_image.m_mapImageAllocation,
+				.m_flags 			= flags
+			});
+			texture.m_image.m_width = (int)d.m_width;
+			texture.m_image.m_height = (int)d.m_height;
+			texture.m_image.m_layers = (int)layers;
+			texture.m_image.m_mipLevels = d.m_mipLevels;
+			texture.m_format = d.m_format;
+			texture.m_layers = d.m_layers;
+			texture.m_faces = d.m_faces;
+		}
+
+		/// Mark a texture as failed and give back its staging memory.
+		void Fail(Decoded& d) {
+			auto& texture = m_textures[d.m_handle];
+			texture.m_state = State::Failed;
+			texture.m_error = d.m_error;
+			--m_outstanding;
+			ReleaseStaging(d);
+		}
+
+		void ReleaseStaging(Decoded& d) {
+			if( d.m_dedicated ) {
+				BufDestroyBuffer({m_device, m_vmaAllocator, d.m_buffer, d.m_dedicated});
+				d.m_dedicated = nullptr;
+			} else if( d.m_slice != ~0ull ) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_ring.Release(d.m_slice);
+				d.m_slice = ~0ull;
+			}
+			d.m_buffer = VK_NULL_HANDLE;
+		}
+
+		auto Retire() -> uint32_t {
+			uint32_t ready = 0;
+			while( !m_batches.empty() && vkGetFenceStatus(m_device, m_batches.front().m_fence) == VK_SUCCESS ) {
+				Batch& batch = m_batches.front();
+				for( auto& d : batch.m_textures ) {
+					auto& texture = m_textures[d.m_handle];
+					VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D;
+					if( texture.m_faces == 6 ) viewType = texture.m_layers > 1 ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+					else if( texture.m_layers > 1 ) viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+					uint32_t layers = (uint32_t)texture.m_image.m_layers;
+
+					texture.m_image.m_mapImageView = ImgCreateImageView({
+						.m_device 		= m_device,
+						.m_image 		= texture.m_image.m_mapImage,
+						.m_format 		= texture.m_format,
+						.m_aspects 		= VK_IMAGE_ASPECT_COLOR_BIT,
+						.m_layers 		= layers,
+						.m_mipLevels 	= texture.m_image.m_mipLevels,
+						.m_viewType 	= viewType,
+						.m_pAllocator 	= m_pAllocator
+					});
+					ImgCreateTextureSampler({
+						.m_physicalDevice 	= m_physicalDevice,
+						.m_device 			= m_device,
+						.m_texture 			= texture.m_image,
+						.m_pAllocator 		= m_pAllocator,
+						.m_samplerCache 	= m_samplerCache
+					});
+					texture.m_state = State::Ready;
+					--m_outstanding;
+					++ready;
+
+					ReleaseStaging(d);
+				}
+				vkDestroyFence(m_device, batch.m_fence, m_pAllocator);
+				vkFreeCommandBuffers(m_device, m_commandPool, 1, &batch.m_commandBuffer);
+				m_batches.pop_front();
+			}
+			return ready;
+		}
+
+		ThreadPool& 			m_threadPool;
+		VkPhysicalDevice 		m_physicalDevice{VK_NULL_HANDLE};
+		VkDevice 				m_device{VK_NULL_HANDLE};
+		VmaAllocator 			m_vmaAllocator{nullptr};
+		VkQueue 				m_queue{VK_NULL_HANDLE};
+		VkCommandPool 			m_commandPool{VK_NULL_HANDLE};
+		SamplerCache* 			m_samplerCache{nullptr};
+		const VkAllocationCallbacks* m_pAllocator{nullptr};
+		bool 					m_blitSrgb{false};
+		bool 					m_blitUnorm{false};
+		Image 					m_placeholder{};	//bound while a texture is loading or failed
+
+		std::deque<Texture> 	m_textures;		//indexed by handle, owner thread only
+		std::deque<Batch> 		m_batches;		//submitted, oldest first
+		uint32_t 				m_outstanding{0};	//requested but neither ready nor failed
+		std::vector<Decoded> 	m_deferred;		//decoded, waiting for ring space
+
+		std::mutex 				m_mutex;		//guards m_ring, m_decoded and m_statistics
+		std::condition_variable m_decodedCondition;
+		Ring 					m_ring;
+		std::vector<Decoded> 	m_decoded;
+		Statistics 				m_statistics;
+	};
+
+} // namespace vvh
+
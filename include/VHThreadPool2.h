@@ -0,0 +1,84 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// A fixed set of worker threads with a FIFO task queue, shared by encoding, decoding and compile jobs.
+	// The destructor finishes all queued tasks before joining the workers.
+
+	class ThreadPool {
+	public:
+		explicit ThreadPool(uint32_t threads = std::max(2u, std::thread::hardware_concurrency()) - 1) {
+			for( uint32_t i = 0; i < threads; ++i ) m_workers.emplace_back([this] { Worker(); });
+		}
+
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+			m_condition.notify_all();
+			for( auto& worker : m_workers ) worker.join();
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/// @brief Queue a task, its result or exception is returned through the future.
+		template<typename F>
+		auto Submit(F&& func) -> std::future<std::invoke_result_t<F>> {
+			using R = std::invoke_result_t<F>;
+			auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+			auto future = task->get_future();
+			Enqueue([task] { (*task)(); });
+			return future;
+		}
+
+		/// @brief Queue a task without a future. Exceptions must not leave the task.
+		void Enqueue(std::function<void()> task) {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_tasks.push_back(std::move(task));
+			}
+			m_condition.notify_one();
+		}
+
+		auto Size() const -> uint32_t { return (uint32_t)m_workers.size(); }
+		auto QueueDepth() -> size_t { std::lock_guard<std::mutex> lock(m_mutex); return m_tasks.size(); }
+
+	private:
+		void Worker() {
+			VVH_TRACE_THREAD("pool worker");
+			while( true ) {
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_condition.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+					if( m_tasks.empty() ) return;	//stopped and drained
+					task = std::move(m_tasks.front());
+					m_tasks.pop_front();
+				}
+				VVH_ZONE("task");
+				task();
+			}
+		}
+
+		std::vector<std::thread> 			m_workers;
+		std::deque<std::function<void()>> 	m_tasks;
+		std::mutex 							m_mutex;
+		std::condition_variable 			m_condition;
+		bool 								m_stop{false};
+	};
+
+} // namespace vvh
+
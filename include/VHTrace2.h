@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+
+
+//-------------------------------------------------------------------------------------------------
+// CPU profiler zones. Compile with VVH_PROFILE to enable them, otherwise all macros expand to nothing.
+//
+//   VVH_ZONE("name");          time the enclosing scope, name must have static storage duration
+//   VVH_ZONE_FUNCTION;         time the enclosing function under its own name
+//   VVH_TRACE_THREAD("name");  label the calling thread in the trace
+//   VVH_TRACE_WRITE("path");   write all recorded zones as Chrome Trace Event JSON (chrome://tracing, Perfetto)
+
+#ifdef VVH_PROFILE
+
+#define VVH_TRACE_CONCAT2(a, b) a##b
+#define VVH_TRACE_CONCAT(a, b) VVH_TRACE_CONCAT2(a, b)
+#define VVH_ZONE(name) ::vvh::CpuZone VVH_TRACE_CONCAT(vvhZone, __LINE__){name}
+#define VVH_ZONE_FUNCTION VVH_ZONE(__func__)
+#define VVH_TRACE_THREAD(name) ::vvh::CpuTrace::Instance().SetThreadName(name)
+#define VVH_TRACE_WRITE(path) ::vvh::CpuTrace::Instance().Write(path)
+
+#ifndef VVH_PROFILE_EVENTS
+	#define VVH_PROFILE_EVENTS (1 << 16)	//zones kept per thread, must be a power of two
+#endif
+
+namespace vvh {
+
+	//---------------------------------------------------------------------------------------------
+	// Every thread records its zones into its own ring buffer, so recording takes no lock. Only the first zone
+	// of a thread takes the registry lock to create its buffer. Buffers live until the end of the program, so
+	// zones of finished threads can still be written. When a ring is full the oldest zones are overwritten.
+
+	struct CpuTraceEvent {
+		std::atomic<const char*> 	m_name{nullptr};
+		std::atomic<int64_t> 		m_start{0};	//nanoseconds since the trace epoch
+		std::atomic<int64_t> 		m_end{0};
+	};
+
+	struct CpuTraceBuffer {
+		static constexpr uint64_t c_capacity = VVH_PROFILE_EVENTS;
+		static_assert((c_capacity & (c_capacity - 1)) == 0, "VVH_PROFILE_EVENTS must be a power of two");
+
+		/// Single producer, the owning thread. The writing counter is raised before a slot is overwritten so
+		/// that a concurrent reader can drop slots that changed while it copied them.
+		void Push(const char* name, int64_t start, int64_t end) {
+			uint64_t index = m_head.load(std::memory_order_relaxed);
+			m_writing.store(index + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			auto& event = m_events[index & (c_capacity - 1)];
+			event.m_name.store(name, std::memory_order_relaxed);
+			event.m_start.store(start, std::memory_order_relaxed);
+			event.m_end.store(end, std::memory_order_relaxed);
+			m_head.store(index + 1, std::memory_order_release);
+		}
+
+		std::atomic<uint64_t> 				m_head{0};
+		std::atomic<uint64_t> 				m_writing{0};
+		std::unique_ptr<CpuTraceEvent[]> 	m_events{new CpuTraceEvent[c_capacity]};
+		uint32_t 							m_tid{0};
+		std::string 						m_name;		//guarded by the registry mutex
+	};
+
+	class CpuTrace {
+	public:
+		static auto Instance() -> CpuTrace& {
+			static CpuTrace trace;
+			return trace;
+		}
+
+		auto Now() const -> int64_t {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+		}
+
+		auto ThreadBuffer() -> CpuTraceBuffer& {
+			thread_local CpuTraceBuffer* buffer = nullptr;
+			if( buffer == nullptr ) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_buffers.push_back(std::make_unique<CpuTraceBuffer>());
+				buffer = m_buffers.back().get();
+				buffer->m_tid = (uint32_t)m_buffers.size();
+			}
+			return *buffer;
+		}
+
+		void SetThreadName(const std::string& name) {
+			auto& buffer = ThreadBuffer();
+			std::lock_guard<std::mutex> lock(m_mutex);
+			buffer.m_name = name;
+		}
+
+		/// @brief Write the zones of all threads in Chrome Trace Event format. Threads may keep recording meanwhile.
+		void Write(const std::string& path) {
+			std::ofstream file(path);
+			if (!file.is_open()) {
+				throw std::runtime_error("failed to open trace file!");
+			}
+			file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+			bool first = true;
+			auto separator = [&]() -> std::ofstream& { if( !first ) file << ",\n"; first = false; return file; };
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for( auto& buffer : m_buffers ) {
+				if( !buffer->m_name.empty() ) {
+					separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->m_tid
+						<< ",\"args\":{\"name\":\"" << Escape(buffer->m_name) << "\"}}";
+				}
+
+				uint64_t head = buffer->m_head.load(std::memory_order_acquire);
+				uint64_t begin = head > CpuTraceBuffer::c_capacity ? head - CpuTraceBuffer::c_capacity : 0;
+				struct Copy { const char* m_name; int64_t m_start; int64_t m_end; };
+				std::vector<Copy> copies;
+				copies.reserve(head - begin);
+				for( uint64_t i = begin; i < head; ++i ) {
+					auto& event = buffer->m_events[i & (CpuTraceBuffer::c_capacity - 1)];
+					copies.push_back({ event.m_name.load(std::memory_order_relaxed),
+						event.m_start.load(std::memory_order_relaxed), event.m_end.load(std::memory_order_relaxed) });
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+
+				//slots of indices below writing - capacity may have been overwritten while copying
+				uint64_t writing = buffer->m_writing.load(std::memory_order_relaxed);
+				uint64_t valid = writing > CpuTraceBuffer::c_capacity ? writing - CpuTraceBuffer::c_capacity : 0;
+				for( uint64_t i = std::max(begin, valid); i < head; ++i ) {
+					auto& copy = copies[i - begin];
+					separator() << "{\"name\":\"" << Escape(copy.m_name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->m_tid
+						<< ",\"ts\":" << copy.m_start / 1000.0 << ",\"dur\":" << (copy.m_end - copy.m_start) / 1000.0 << "}";
+				}
+			}
+			file << "\n]}\n";
+		}
+
+	private:
+		CpuTrace() : m_epoch{std::chrono::steady_clock::now()} {}
+
+		static auto Escape(const std::string& str) -> std::string {
+			std::string result;
+			for( char c : str ) {
+				if( c == '"' || c == '\\' ) result += '\\';
+				if( (unsigned char)c >= 0x20 ) result += c;
+			}
+			return result;
+		}
+
+		std::chrono::steady_clock::time_point 		 m_epoch;
+		std::mutex 									 m_mutex;
+		std::vector<std::unique_ptr<CpuTraceBuffer>> m_buffers;
+	};
+
+	/// Records the time between construction and destruction into the calling thread's ring buffer.
+	class CpuZone {
+	public:
+		explicit CpuZone(const char* name)
+			: m_buffer{CpuTrace::Instance().ThreadBuffer()}, m_name{name}, m_start{CpuTrace::Instance().Now()} {}
+		~CpuZone() { m_buffer.Push(m_name, m_start, CpuTrace::Instance().Now()); }
+
+		CpuZone(const CpuZone&) = delete;
+		CpuZone& operator=(const CpuZone&) = delete;
+
+	private:
+		CpuTraceBuffer& m_buffer;
+		const char* 	m_name;
+		int64_t 		m_start;
+	};
+
+} // namespace vvh
+
+#else
+
+#define VVH_ZONE(name) ((void)0)
+#define VVH_ZONE_FUNCTION ((void)0)
+#define VVH_TRACE_THREAD(name) ((void)0)
+#define VVH_TRACE_WRITE(path) ((void)0)
+
+#endif
+
@@ -15,6 +15,19 @@
 #include <optional>
 #include <set>
 #include <unordered_map>
+#include <span>
+#include <utility>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#define VVH_HAVE_MMAP
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#include "VHTrace2.h"
 
 #define MAX_FRAMES_IN_FLIGHT 2
 #define MAXINFLIGHT 2
@@ -48,6 +61,88 @@ namespace vvh {
         return buffer;
     }
 
+	//--------------------------------------------------------------------
+	/// Read-only view of a whole file. On POSIX systems the file is mapped into memory,
+	/// so loaders can copy from the page cache straight into staging buffers.
+	/// Elsewhere, or if mapping fails, the file is read into a heap buffer.
+
+	class FileView {
+	public:
+		FileView() = default;
+		explicit FileView(const std::string& filename) { Open(filename); }
+		~FileView() { Close(); }
+
+		FileView(const FileView&) = delete;
+		FileView& operator=(const FileView&) = delete;
+		FileView(FileView&& other) noexcept { *this = std::move(other); }
+
+		FileView& operator=(FileView&& other) noexcept {
+			if( this == &other ) return *this;
+			Close();
+			m_data = std::exchange(other.m_data, nullptr);
+			m_size = std::exchange(other.m_size, 0);
+			m_mapped = std::exchange(other.m_mapped, false);
+			m_buffer = std::move(other.m_buffer);
+			return *this;
+		}
+
+		void Open(const std::string& filename) {
+			Close();
+		#ifdef VVH_HAVE_MMAP
+			int fd = ::open(filename.c_str(), O_RDONLY);
+			if( fd < 0 ) {
+				std::cout << "failed to open file: " << filename << std::endl;
+				throw std::runtime_error("failed to open file!");
+			}
+			struct stat st;
+			if( fstat(fd, &st) == 0 && st.st_size > 0 ) {
+				m_size = (size_t)st.st_size;
+				void* ptr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if( ptr != MAP_FAILED ) {
+					madvise(ptr, m_size, MADV_SEQUENTIAL);
+					m_data = (const uint8_t*)ptr;
+					m_mapped = true;
+				} else {
+					m_buffer.resize(m_size);
+					size_t done = 0;
+					while( done < m_size ) {
+						ssize_t n = ::read(fd, m_buffer.data() + done, m_size - done);
+						if( n <= 0 ) { ::close(fd); throw std::runtime_error("failed to read file!"); }
+						done += (size_t)n;
+					}
+					m_data = (const uint8_t*)m_buffer.data();
+				}
+			}
+			::close(fd);
+		#else
+			m_buffer = ReadFile(filename);
+			m_data = (const uint8_t*)m_buffer.data();
+			m_size = m_buffer.size();
+		#endif
+		}
+
+		void Close() {
+		#ifdef VVH_HAVE_MMAP
+			if( m_mapped ) munmap((void*)m_data, m_size);
+		#endif
+			m_data = nullptr;
+			m_size = 0;
+			m_mapped = false;
+			m_buffer = {};
+		}
+
+		auto Data() const -> const uint8_t* { return m_data; }
+		auto Size() const -> size_t { return m_size; }
+		auto Span() const -> std::span<const char> { return { (const char*)m_data, m_size }; }
+		bool IsMapped() const { return m_mapped; }
+
+	private:
+		const uint8_t* 		m_data{nullptr};
+		size_t 				m_size{0};
+		bool 				m_mapped{false};
+		std::vector<char> 	m_buffer;
+	};
+
 
 
 	//--------------------------------------------------------------------
@@ -159,6 +254,7 @@ namespace vvh {
 		int 			m_width;
 		int				m_height;
 		int				m_layers;
+		uint32_t		m_mipLevels{1};
 		VkDeviceSize	m_size;
 		void *			m_pixels{nullptr};
 		VkImage         m_mapImage;
@@ -167,6 +263,23 @@ namespace vvh {
         VkSampler       m_mapSampler;
     };
 
+	/// Texture data as stored in a container file (KTX2, DDS), ready to be copied into an image.
+	/// m_regions hold one entry per mip level and layer, their bufferOffset is relative to m_data.
+	/// m_data usually points into m_file, which keeps the mapping alive.
+	struct TextureData {
+		VkFormat 		m_format{VK_FORMAT_UNDEFINED};
+		uint32_t 		m_width{0};
+		uint32_t 		m_height{0};
+		uint32_t 		m_depth{1};
+		uint32_t 		m_layers{1};
+		uint32_t 		m_faces{1};		//6 for cube maps
+		uint32_t 		m_mipLevels{1};
+		std::vector<VkBufferImageCopy> m_regions;
+		const uint8_t* 	m_data{nullptr};
+		size_t 			m_size{0};
+		FileView 		m_file;
+	};
+
 	struct Buffer {
 		VkDeviceSize 				m_bufferSize{0};
         std::vector<VkBuffer>       m_uniformBuffers;
@@ -180,8 +293,9 @@ namespace vvh {
 	};
 
     struct SwapChain {
-        VkSwapchainKHR m_swapChain;
+        VkSwapchainKHR m_swapChain{VK_NULL_HANDLE}; //VK_NULL_HANDLE for an offscreen swap chain
         std::vector<VkImage> m_swapChainImages;
+        std::vector<VmaAllocation> m_swapChainAllocations; //only offscreen images are owned
         VkFormat m_swapChainImageFormat;
         VkExtent2D m_swapChainExtent;
         std::vector<VkImageView> m_swapChainImageViews;
@@ -193,12 +307,29 @@ namespace vvh {
         VkPipeline m_pipeline;
     };
 
+	/// Compute pipeline for generating mip levels of formats that do not support linear blits.
+	/// Set 0 holds the source (binding 0) and destination (binding 1) level as storage images.
+	struct MipmapPipeline {
+		VkDescriptorSetLayout 	m_descriptorSetLayout{VK_NULL_HANDLE};
+		VkPipelineLayout 		m_pipelineLayout{VK_NULL_HANDLE};
+		VkPipeline 				m_pipeline{VK_NULL_HANDLE};
+	};
+
 	/// Pipeline code:
 	/// P...Vertex data contains positions
 	/// N...Vertex data contains normals
 	/// T...Vertex data contains tangents
 	/// C...Vertex data contains colors
 	/// U...Vertex data contains texture UV coordinates
+	/// Bits of VertexData::getTypeMask(), in the order the attributes are stored and bound.
+	enum VertexFormatBits : uint32_t {
+		VERTEX_POSITION = 1 << 0,	//P
+		VERTEX_NORMAL 	= 1 << 1,	//N
+		VERTEX_TEXCOORD = 1 << 2,	//U
+		VERTEX_COLOR 	= 1 << 3,	//C
+		VERTEX_TANGENT 	= 1 << 4	//T
+	};
+
 	struct VertexData {
 
 		static const int size_pos = sizeof(glm::vec3);
@@ -223,6 +354,29 @@ namespace vvh {
 			return name;
 		}
 
+		/// @brief Same as getType() as VertexFormatBits, without building a string.
+		uint32_t getTypeMask() const {
+			return 	(m_positions.size() > 0 ? VERTEX_POSITION : 0) |
+					(m_normals.size() > 0   ? VERTEX_NORMAL : 0) |
+					(m_texCoords.size() > 0 ? VERTEX_TEXCOORD : 0) |
+					(m_colors.size() > 0    ? VERTEX_COLOR : 0) |
+					(m_tangents.size() > 0  ? VERTEX_TANGENT : 0);
+		}
+
+		static uint32_t getTypeMask( const std::string& type ) {
+			uint32_t mask = 0;
+			for( char c : type ) {
+				switch( c ) {
+					case 'P': mask |= VERTEX_POSITION; break;
+					case 'N': mask |= VERTEX_NORMAL; break;
+					case 'U': mask |= VERTEX_TEXCOORD; break;
+					case 'C': mask |= VERTEX_COLOR; break;
+					case 'T': mask |= VERTEX_TANGENT; break;
+				}
+			}
+			return mask;
+		}
+
 		VkDeviceSize getSize() const {
 			return 	m_positions.size() * sizeof(glm::vec3) + 
 					m_normals.size()   * sizeof(glm::vec3) + 
@@ -297,9 +451,28 @@ namespace vvh {
 
 }
 
+#include "VHAllocator2.h"
+#include "VHSwizzle2.h"
 #include "VHBuffer2.h"
+#include "VHReadback2.h"
+#include "VHThreadPool2.h"
+#include "VHCapture2.h"
 #include "VHImage2.h"
 #include "VHDevice2.h"
 #include "VHSync2.h"
 #include "VHCommand2.h"
+#include "VHProfiler2.h"
+#include "VHPipelineCache2.h"
 #include "VHRender2.h"
+#include "VHShaderReflection2.h"
+#include "VHDescriptorAllocator2.h"
+#include "VHDescriptorWriter2.h"
+#include "VHDescriptorCache2.h"
+#include "VHDescriptorBuffer2.h"
+#include "VHShaderLibrary2.h"
+#include "VHShaderCompiler2.h"
+#include "VHPipelineBuilder2.h"
+#include "VHPipelineRegistry2.h"
+#include "VHShaderReload2.h"
+#include "VHTexture2.h"
+#include "VHTextureLoader2.h"